@@ -15,6 +15,7 @@ app_t *app_create(app_settings_t *settings, void *disp) {
     app->settings = settings;
     app->main_thread_id = SDL_ThreadID();
     app->running = true;
+    app_main_tasks_init(app);
     bool client_info_loaded = client_info_load(&app->client_info);
     assert(client_info_loaded);
     app->input_manager = input_manager_create();
@@ -31,6 +32,7 @@ void app_destroy(app_t *app) {
     host_manager_destroy(app->host_manager);
     input_manager_destroy(app->input_manager);
     client_info_clear(&app->client_info);
+    app_main_tasks_deinit(app);
     free(app);
 }
 
@@ -7,12 +7,14 @@
 #include "ss4s.h"
 #include "settings/app_settings.h"
 #include "util/client_info.h"
+#include "util/completion.h"
 #include "os_info.h"
 
 typedef struct app_ui_t app_ui_t;
 typedef struct stream_manager_t stream_manager_t;
 typedef struct host_manager_t host_manager_t;
 typedef struct input_manager_t input_manager_t;
+typedef struct app_main_tasks_t app_main_tasks_t;
 
 typedef struct app_t {
     bool running;
@@ -21,9 +23,11 @@ typedef struct app_t {
     app_settings_t *settings;
     client_info_t client_info;
     os_info_t os_info;
+    SDL_Window *window;
     host_manager_t *host_manager;
     stream_manager_t *stream_manager;
     input_manager_t *input_manager;
+    app_main_tasks_t *main_tasks;
 } app_t;
 
 typedef enum app_event_type_t {
@@ -41,6 +45,19 @@ typedef enum app_event_type_t {
 
 typedef void(*app_run_action_fn)(app_t *, void *);
 
+typedef struct app_main_tasks_stats_t {
+    uint32_t pushed;
+    uint32_t executed;
+    /** Number of tasks waiting to be run */
+    uint32_t depth;
+    uint32_t max_depth;
+    /** Number of wake up events posted. Tasks pushed in a burst share one */
+    uint32_t wakeups;
+    /** Time from app_run_on_main to the task being run */
+    uint32_t avg_latency_us;
+    uint32_t max_latency_us;
+} app_main_tasks_stats_t;
+
 void app_preinit(int argc, char *argv[]);
 
 app_t *app_create(app_settings_t *settings, void *disp);
@@ -51,10 +68,30 @@ void app_quit(app_t *app);
 
 void app_post_event(app_t *app, app_event_type_t type, void *data1, void *data2);
 
-void app_run_on_main(app_t *app, app_run_action_fn action, void *data);
+/**
+ * Queue an action to be run by main thread. Can be called from any thread.
+ * @return 0 on success, -1 if the task couldn't be allocated
+ */
+int app_run_on_main(app_t *app, app_run_action_fn action, void *data);
 
 void app_run_on_main_sync(app_t *app, app_run_action_fn action, void *data);
 
+/**
+ * Same as app_run_on_main_sync, but waits on a completion owned by caller instead of the one cached for the thread.
+ */
+void app_run_on_main_sync_with(app_t *app, completion_t *completion, app_run_action_fn action, void *data);
+
+void app_main_tasks_init(app_t *app);
+
+void app_main_tasks_deinit(app_t *app);
+
+/**
+ * Run tasks queued by app_run_on_main. Called once per main loop iteration.
+ */
+void app_main_tasks_run(app_t *app);
+
+void app_main_tasks_get_stats(app_t *app, app_main_tasks_stats_t *stats);
+
 void app_sdl_input_event(app_t *app, const SDL_Event *event);
 
 void app_assert_main_thread(app_t *app);
@@ -1,16 +1,62 @@
+#include <stdlib.h>
+
 #include "app.h"
+#include "logging.h"
+#include "util/completion.h"
+#include "util/mpsc_queue.h"
 
-typedef struct bus_blocking_action_t {
+/** Task nodes kept for reuse, so posting a task doesn't allocate in steady state */
+#define FREE_TASKS_MAX 64
+
+typedef struct app_main_task_t app_main_task_t;
+
+struct app_main_tasks_t {
+    mpsc_queue_t queue;
+    /** Recycled tasks, guarded by free_lock as tasks are taken by any thread */
+    app_main_task_t *free_tasks;
+    uint32_t free_count;
+    SDL_SpinLock free_lock;
+    /** Set when a wake up event is posted and the main loop hasn't started running tasks yet */
+    SDL_atomic_t wakeup_pending;
+
+    SDL_atomic_t pushed;
+    SDL_atomic_t wakeups;
+    /** Below are main thread only */
+    uint32_t executed;
+    uint32_t max_depth;
+    uint64_t total_latency_us;
+    uint32_t max_latency_us;
+};
+
+struct app_main_task_t {
+    mpsc_queue_node_t node;
     app_run_action_fn action;
+    void *data;
+    /** SDL_GetPerformanceCounter() when the task was queued */
+    Uint64 queued_at;
+    /** Task is owned by app_run_on_main_sync caller instead of the queue */
+    bool on_stack;
+    /** Next task in free list */
+    app_main_task_t *next_free;
+};
 
+typedef struct bus_blocking_action_t {
+    app_main_task_t task;
+    app_run_action_fn action;
     void *data;
-    SDL_mutex *mutex;
-    SDL_cond *cond;
-    bool done;
+    completion_t *completion;
 } bus_action_sync_t;
 
+static void push_task(app_t *app, app_main_task_t *task);
+
+static app_main_task_t *obtain_task(app_main_tasks_t *tasks);
+
+static void recycle_task(app_main_tasks_t *tasks, app_main_task_t *task);
+
 static void invoke_action_sync(app_t *app, void *data);
 
+static uint32_t counter_elapsed_us(Uint64 since);
+
 void app_post_event(app_t *app, app_event_type_t type, void *data1, void *data2) {
     (void) app;
     SDL_Event event;
@@ -20,35 +66,172 @@ void app_post_event(app_t *app, app_event_type_t type, void *data1, void *data2)
     SDL_PushEvent(&event);
 }
 
-void app_run_on_main(app_t *app, app_run_action_fn action, void *data) {
-    (void) app;
-    app_post_event(app, APP_RUN_ON_MAIN, action, data);
+int app_run_on_main(app_t *app, app_run_action_fn action, void *data) {
+    app_main_task_t *task = obtain_task(app->main_tasks);
+    if (task == NULL) {
+        commons_log_error("APP", "Failed to allocate main thread task");
+        return -1;
+    }
+    task->action = action;
+    task->data = data;
+    task->on_stack = false;
+    push_task(app, task);
+    return 0;
 }
 
+/**
+ * Blocks until the action has been run by main thread. Nothing is allocated per call, as the task lives on caller's
+ * stack, and the completion is cached per thread.
+ */
 void app_run_on_main_sync(app_t *app, app_run_action_fn action, void *data) {
+    if (SDL_ThreadID() == app->main_thread_id) {
+        action(app, data);
+        return;
+    }
+    app_run_on_main_sync_with(app, completion_get_current(), action, data);
+}
+
+void app_run_on_main_sync_with(app_t *app, completion_t *completion, app_run_action_fn action, void *data) {
+    if (SDL_ThreadID() == app->main_thread_id) {
+        action(app, data);
+        return;
+    }
+    completion_reset(completion);
     bus_action_sync_t sync = {
+            .task.action = invoke_action_sync,
+            .task.on_stack = true,
             .action = action,
             .data = data,
-            .mutex = SDL_CreateMutex(),
-            .cond = SDL_CreateCond(),
-            .done = false,
+            .completion = completion,
     };
-    app_run_on_main(app, invoke_action_sync, &sync);
-    SDL_LockMutex(sync.mutex);
-    while (!sync.done) {
-        SDL_CondWait(sync.cond, sync.mutex);
+    sync.task.data = &sync;
+    push_task(app, &sync.task);
+    completion_wait(sync.completion);
+}
+
+void app_main_tasks_init(app_t *app) {
+    app_main_tasks_t *tasks = calloc(1, sizeof(app_main_tasks_t));
+    mpsc_queue_init(&tasks->queue);
+    app->main_tasks = tasks;
+}
+
+void app_main_tasks_deinit(app_t *app) {
+    app_main_tasks_t *tasks = app->main_tasks;
+    app_main_tasks_stats_t stats;
+    app_main_tasks_get_stats(app, &stats);
+    commons_log_info("APP", "Main thread tasks: executed=%u, max_depth=%u, wakeups=%u, avg_latency=%uus, "
+                            "max_latency=%uus", stats.executed, stats.max_depth, stats.wakeups, stats.avg_latency_us,
+                     stats.max_latency_us);
+    // Tasks posted after the main loop ended won't run, as what they operate on has been destroyed
+    mpsc_queue_node_t *node;
+    while ((node = mpsc_queue_pop(&tasks->queue)) != NULL) {
+        app_main_task_t *task = mpsc_queue_entry(node, app_main_task_t, node);
+        if (!task->on_stack) {
+            free(task);
+        }
+    }
+    while (tasks->free_tasks != NULL) {
+        app_main_task_t *task = tasks->free_tasks;
+        tasks->free_tasks = task->next_free;
+        free(task);
+    }
+    free(tasks);
+    app->main_tasks = NULL;
+}
+
+void app_main_tasks_run(app_t *app) {
+    app_assert_main_thread(app);
+    app_main_tasks_t *tasks = app->main_tasks;
+    // Tasks pushed from now on need another wake up
+    SDL_AtomicSet(&tasks->wakeup_pending, 0);
+    uint32_t depth = (uint32_t) SDL_AtomicGet(&tasks->pushed) - tasks->executed;
+    if (depth > tasks->max_depth) {
+        tasks->max_depth = depth;
+    }
+    // Tasks queued by tasks being run are left for next iteration, so the loop won't starve
+    for (uint32_t i = 0; i < depth; i++) {
+        mpsc_queue_node_t *node = mpsc_queue_pop(&tasks->queue);
+        if (node == NULL) {
+            break;
+        }
+        app_main_task_t *task = mpsc_queue_entry(node, app_main_task_t, node);
+        uint32_t latency_us = counter_elapsed_us(task->queued_at);
+        tasks->total_latency_us += latency_us;
+        if (latency_us > tasks->max_latency_us) {
+            tasks->max_latency_us = latency_us;
+        }
+        tasks->executed++;
+        app_run_action_fn action = task->action;
+        void *data = task->data;
+        if (!task->on_stack) {
+            recycle_task(tasks, task);
+        }
+        action(app, data);
+    }
+    if ((uint32_t) SDL_AtomicGet(&tasks->pushed) != tasks->executed && SDL_AtomicCAS(&tasks->wakeup_pending, 0, 1)) {
+        SDL_AtomicAdd(&tasks->wakeups, 1);
+        app_post_event(app, APP_RUN_ON_MAIN, NULL, NULL);
+    }
+}
+
+void app_main_tasks_get_stats(app_t *app, app_main_tasks_stats_t *stats) {
+    app_main_tasks_t *tasks = app->main_tasks;
+    stats->pushed = (uint32_t) SDL_AtomicGet(&tasks->pushed);
+    stats->executed = tasks->executed;
+    stats->depth = stats->pushed - stats->executed;
+    stats->max_depth = tasks->max_depth;
+    stats->wakeups = (uint32_t) SDL_AtomicGet(&tasks->wakeups);
+    stats->avg_latency_us = tasks->executed > 0 ? (uint32_t) (tasks->total_latency_us / tasks->executed) : 0;
+    stats->max_latency_us = tasks->max_latency_us;
+}
+
+static void push_task(app_t *app, app_main_task_t *task) {
+    app_main_tasks_t *tasks = app->main_tasks;
+    task->queued_at = SDL_GetPerformanceCounter();
+    SDL_AtomicAdd(&tasks->pushed, 1);
+    mpsc_queue_push(&tasks->queue, &task->node);
+    // One wake up event is enough for all tasks pushed before main loop gets to them
+    if (SDL_AtomicCAS(&tasks->wakeup_pending, 0, 1)) {
+        SDL_AtomicAdd(&tasks->wakeups, 1);
+        app_post_event(app, APP_RUN_ON_MAIN, NULL, NULL);
     }
-    SDL_UnlockMutex(sync.mutex);
-    SDL_DestroyMutex(sync.mutex);
-    SDL_DestroyCond(sync.cond);
+}
+
+static app_main_task_t *obtain_task(app_main_tasks_t *tasks) {
+    SDL_AtomicLock(&tasks->free_lock);
+    app_main_task_t *task = tasks->free_tasks;
+    if (task != NULL) {
+        tasks->free_tasks = task->next_free;
+        tasks->free_count--;
+    }
+    SDL_AtomicUnlock(&tasks->free_lock);
+    if (task == NULL) {
+        task = malloc(sizeof(app_main_task_t));
+    }
+    return task;
+}
+
+static void recycle_task(app_main_tasks_t *tasks, app_main_task_t *task) {
+    SDL_AtomicLock(&tasks->free_lock);
+    if (tasks->free_count < FREE_TASKS_MAX) {
+        task->next_free = tasks->free_tasks;
+        tasks->free_tasks = task;
+        tasks->free_count++;
+        task = NULL;
+    }
+    SDL_AtomicUnlock(&tasks->free_lock);
+    // Beyond the cap, a burst of tasks is given back
+    free(task);
 }
 
 static void invoke_action_sync(app_t *app, void *data) {
-    (void) app;
     bus_action_sync_t *sync = data;
-    SDL_LockMutex(sync->mutex);
     sync->action(app, sync->data);
-    sync->done = true;
-    SDL_CondSignal(sync->cond);
-    SDL_UnlockMutex(sync->mutex);
-}
\ No newline at end of file
+    // Caller returns right after this, so sync is gone
+    completion_signal(sync->completion);
+}
+
+static uint32_t counter_elapsed_us(Uint64 since) {
+    Uint64 elapsed = SDL_GetPerformanceCounter() - since;
+    return (uint32_t) (elapsed * 1000000 / SDL_GetPerformanceFrequency());
+}
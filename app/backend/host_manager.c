@@ -8,6 +8,7 @@
 #include "util/listeners_list.h"
 #include "ui/common/error_messages.h"
 #include "logging.h"
+#include "ss4s.h"
 
 struct host_manager_t {
     app_t *app;
@@ -58,6 +59,8 @@ static void client_authorization_failed_main(app_t *app, void *data);
 
 static int compare_host_name(const void *a, const void *b);
 
+static uint32_t session_audio_channel_count();
+
 static const IHS_ClientDiscoveryCallbacks discovery_callbacks = {
         .discovered = client_host_discovered,
 };
@@ -108,7 +111,7 @@ array_list_t *host_manager_get_hosts(host_manager_t *manager) {
 
 void host_manager_session_request(host_manager_t *manager, const IHS_HostInfo *host) {
     IHS_StreamingRequest request = {
-            .audioChannelCount = 2,
+            .audioChannelCount = session_audio_channel_count(),
             .streamingEnable.audio = true,
             .streamingEnable.video = true,
             .streamingEnable.input = true,
@@ -264,4 +267,21 @@ static int compare_host_name(const void *a, const void *b) {
     const IHS_HostInfo *info1 = a;
     const IHS_HostInfo *info2 = b;
     return strncasecmp(info1->hostname, info2->hostname, 63);
-}
\ No newline at end of file
+}
+
+/**
+ * Request as many channels as the audio sink can play, so surround streams won't be downmixed by the host.
+ * Opus surround layouts are 5.1 and 7.1, so other channel counts are rounded down to one of them.
+ */
+static uint32_t session_audio_channel_count() {
+    SS4S_AudioCapabilities audio_cap;
+    if (SS4S_GetAudioCapabilities(&audio_cap) != 0) {
+        return 2;
+    }
+    if (audio_cap.maxChannels >= 8) {
+        return 8;
+    } else if (audio_cap.maxChannels >= 6) {
+        return 6;
+    }
+    return 2;
+}
@@ -0,0 +1,101 @@
+#include "audio_jitter.h"
+
+#include <string.h>
+
+void audio_jitter_init(audio_jitter_t *jitter, int sample_rate, int min_latency_ms, int max_latency_ms) {
+    memset(jitter, 0, sizeof(audio_jitter_t));
+    jitter->sample_rate = sample_rate;
+    jitter->min_latency_us = (int64_t) SDL_max(min_latency_ms, 0) * 1000;
+    jitter->max_latency_us = SDL_max((int64_t) max_latency_ms * 1000, jitter->min_latency_us);
+    jitter->target_us = jitter->min_latency_us;
+}
+
+void audio_jitter_arrived(audio_jitter_t *jitter, Uint64 now_us, int64_t duration_us) {
+    if (duration_us <= 0) {
+        jitter->expected_us = now_us;
+        return;
+    }
+    int64_t late = audio_jitter_lateness(jitter, now_us, duration_us);
+    // Clock follows the earliest arrivals
+    jitter->expected_us = now_us - late;
+    jitter->jitter_us += (late - jitter->jitter_us) / 16;
+    jitter->peak_us = SDL_max(late, jitter->peak_us - jitter->peak_us / 1024);
+    int64_t target = jitter->peak_us + duration_us;
+    jitter->target_us = SDL_max(SDL_min(target, jitter->max_latency_us), jitter->min_latency_us);
+}
+
+int64_t audio_jitter_lateness(const audio_jitter_t *jitter, Uint64 now_us, int64_t duration_us) {
+    if (duration_us <= 0) {
+        return 0;
+    }
+    int64_t late = (int64_t) (now_us - (jitter->expected_us + duration_us));
+    return late < 0 ? 0 : late;
+}
+
+audio_jitter_action_t audio_jitter_check(audio_jitter_t *jitter, Uint64 now_us, int frame_samples,
+                                         int *prefill_samples) {
+    *prefill_samples = 0;
+    int64_t backlog = audio_jitter_backlog_us(jitter, now_us);
+    if (!jitter->playing || backlog < 0) {
+        if (jitter->playing) {
+            jitter->underruns++;
+        }
+        jitter->playing = true;
+        jitter->play_start_us = now_us;
+        jitter->fed_samples = 0;
+        *prefill_samples = (int) (jitter->target_us * jitter->sample_rate / 1000000);
+        return AUDIO_JITTER_FEED;
+    }
+    int64_t frame_us = (int64_t) frame_samples * 1000000 / jitter->sample_rate;
+    if (backlog > jitter->max_latency_us || backlog > jitter->target_us * 2 + frame_us) {
+        jitter->dropped_frames++;
+        return AUDIO_JITTER_DROP;
+    }
+    if (backlog > jitter->target_us + frame_us) {
+        jitter->compressed_frames++;
+        return AUDIO_JITTER_COMPRESS;
+    }
+    return AUDIO_JITTER_FEED;
+}
+
+void audio_jitter_fed(audio_jitter_t *jitter, int samples, bool accepted) {
+    if (!accepted) {
+        // Sink isn't playing yet, start over when it accepts data
+        jitter->playing = false;
+        return;
+    }
+    jitter->fed_samples += samples;
+}
+
+int audio_jitter_compress(void *pcm, int channels, int samples, bool is_float) {
+    int out_samples = samples - samples / 4;
+    if (out_samples <= 1) {
+        return samples;
+    }
+    int16_t *s16 = pcm;
+    float *f32 = pcm;
+    // Output is never ahead of input, so it can be done in place
+    for (int i = 0; i < out_samples; i++) {
+        // Position in Q8, 64-bit as 120ms frames overflow int
+        int pos = (int) ((int64_t) i * (samples - 1) * 256 / (out_samples - 1));
+        int index = pos >> 8, frac = pos & 0xFF;
+        int next = index + 1 < samples ? index + 1 : index;
+        for (int ch = 0; ch < channels; ch++) {
+            if (is_float) {
+                float a = f32[index * channels + ch], b = f32[next * channels + ch];
+                f32[i * channels + ch] = a + (b - a) * (float) frac / 256.0f;
+            } else {
+                int a = s16[index * channels + ch], b = s16[next * channels + ch];
+                s16[i * channels + ch] = (int16_t) (a + ((b - a) * frac >> 8));
+            }
+        }
+    }
+    return out_samples;
+}
+
+int64_t audio_jitter_backlog_us(const audio_jitter_t *jitter, Uint64 now_us) {
+    if (!jitter->playing) {
+        return 0;
+    }
+    return (int64_t) (jitter->fed_samples * 1000000 / jitter->sample_rate) - (int64_t) (now_us - jitter->play_start_us);
+}
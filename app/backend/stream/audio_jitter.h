@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL.h>
+
+/**
+ * Keeps the audio sink backlog around a target latency, which adapts to the jitter of packet arrivals.
+ *
+ * The sink is assumed to play at nominal sample rate once started, so its backlog is estimated as samples fed minus
+ * time elapsed since playback started.
+ */
+typedef struct audio_jitter_t {
+    int sample_rate;
+    int64_t min_latency_us, max_latency_us;
+    int64_t target_us;
+    /** When next packet is expected to arrive, following the lower envelope of arrival times */
+    Uint64 expected_us;
+    /** Smoothed lateness of packets against expected arrival time */
+    int64_t jitter_us;
+    /** Peak lateness, decays slowly so occasional hiccups are still covered */
+    int64_t peak_us;
+    /** Whether the sink is playing. Cleared on start and on underrun, so the target backlog will be filled again */
+    bool playing;
+    Uint64 play_start_us;
+    uint64_t fed_samples;
+
+    uint32_t underruns;
+    uint32_t dropped_frames;
+    uint32_t compressed_frames;
+} audio_jitter_t;
+
+typedef enum audio_jitter_action_t {
+    AUDIO_JITTER_FEED,
+    /** Backlog is above target, feed the frame time-compressed with audio_jitter_compress */
+    AUDIO_JITTER_COMPRESS,
+    /** Backlog is way above target, drop the frame */
+    AUDIO_JITTER_DROP,
+} audio_jitter_action_t;
+
+void audio_jitter_init(audio_jitter_t *jitter, int sample_rate, int min_latency_ms, int max_latency_ms);
+
+/**
+ * Update jitter estimation and target latency with a packet arrival.
+ * @param duration_us Duration of previous packet, 0 for the first one
+ */
+void audio_jitter_arrived(audio_jitter_t *jitter, Uint64 now_us, int64_t duration_us);
+
+/**
+ * Lateness a packet arriving now would have, without updating any state.
+ * @param duration_us Duration of samples fed since last arrival, 0 for the first packet
+ * @return Microseconds behind expected arrival time, 0 if early
+ */
+int64_t audio_jitter_lateness(const audio_jitter_t *jitter, Uint64 now_us, int64_t duration_us);
+
+/**
+ * Decide what to do with a decoded frame.
+ * @param prefill_samples Set to number of silent samples to be fed before the frame, to fill up the backlog
+ */
+audio_jitter_action_t audio_jitter_check(audio_jitter_t *jitter, Uint64 now_us, int frame_samples,
+                                         int *prefill_samples);
+
+/**
+ * Record result of feeding samples to the sink.
+ */
+void audio_jitter_fed(audio_jitter_t *jitter, int samples, bool accepted);
+
+/**
+ * Shorten interleaved PCM by a quarter, with linear interpolation.
+ * @param pcm int16_t or float samples
+ * @return Number of samples per channel after compression
+ */
+int audio_jitter_compress(void *pcm, int channels, int samples, bool is_float);
+
+int64_t audio_jitter_backlog_us(const audio_jitter_t *jitter, Uint64 now_us);
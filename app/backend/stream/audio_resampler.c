@@ -0,0 +1,102 @@
+#include "audio_resampler.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define ONE ((uint64_t) 1 << 32)
+#define CONTROLLER_PERIOD_US 1000000
+/** 1ms of backlog error gives 50ppm correction */
+#define KP_DIVISOR 20
+/** Persisting 1ms of error for 1s adds 5ppm */
+#define KI_DIVISOR 200
+
+static void set_ppm(audio_resampler_t *resampler, int ppm);
+
+static int process_s16(audio_resampler_t *resampler, const int16_t *in, int in_samples, int16_t *out);
+
+static int process_f32(audio_resampler_t *resampler, const float *in, int in_samples, float *out);
+
+void audio_resampler_init(audio_resampler_t *resampler, int channels, bool is_float) {
+    assert(channels > 0 && channels <= AUDIO_RESAMPLER_MAX_CHANNELS);
+    memset(resampler, 0, sizeof(audio_resampler_t));
+    resampler->channels = channels;
+    resampler->is_float = is_float;
+    resampler->position = ONE;
+    set_ppm(resampler, 0);
+}
+
+void audio_resampler_update(audio_resampler_t *resampler, Uint64 now_us, int64_t error_us) {
+    if (resampler->period_start_us == 0) {
+        resampler->period_start_us = now_us;
+    }
+    resampler->error_sum_us += error_us;
+    resampler->error_count++;
+    if (now_us - resampler->period_start_us < CONTROLLER_PERIOD_US) {
+        return;
+    }
+    int64_t error = resampler->error_sum_us / resampler->error_count;
+    resampler->error_sum_us = 0;
+    resampler->error_count = 0;
+    resampler->period_start_us = now_us;
+
+    int64_t integral_max = (int64_t) AUDIO_RESAMPLER_MAX_PPM * KI_DIVISOR;
+    resampler->integral_us = SDL_max(SDL_min(resampler->integral_us + error, integral_max), -integral_max);
+    int64_t ppm = error / KP_DIVISOR + resampler->integral_us / KI_DIVISOR;
+    set_ppm(resampler, (int) SDL_max(SDL_min(ppm, AUDIO_RESAMPLER_MAX_PPM), -AUDIO_RESAMPLER_MAX_PPM));
+}
+
+int audio_resampler_process(audio_resampler_t *resampler, const void *in, int in_samples, void *out) {
+    if (in_samples <= 0) {
+        return 0;
+    }
+    if (resampler->is_float) {
+        return process_f32(resampler, in, in_samples, out);
+    }
+    return process_s16(resampler, in, in_samples, out);
+}
+
+static void set_ppm(audio_resampler_t *resampler, int ppm) {
+    resampler->ppm = ppm;
+    resampler->step = ONE + (int64_t) ONE * ppm / 1000000;
+}
+
+/**
+ * Input sample i is at position i + 1, and the last sample of previous frame is at 0
+ */
+static int process_s16(audio_resampler_t *resampler, const int16_t *in, int in_samples, int16_t *out) {
+    int channels = resampler->channels;
+    int out_samples = 0;
+    uint64_t end = (uint64_t) in_samples << 32;
+    uint64_t position = resampler->position;
+    for (; position < end; position += resampler->step, out_samples++) {
+        uint32_t index = (uint32_t) (position >> 32);
+        int32_t frac = (int32_t) ((position & (ONE - 1)) >> 17);
+        const int16_t *a = index == 0 ? resampler->last.s16 : &in[(index - 1) * channels];
+        const int16_t *b = &in[index * channels];
+        for (int ch = 0; ch < channels; ch++) {
+            out[out_samples * channels + ch] = (int16_t) (a[ch] + ((b[ch] - a[ch]) * frac >> 15));
+        }
+    }
+    resampler->position = position - end;
+    memcpy(resampler->last.s16, &in[(in_samples - 1) * channels], channels * sizeof(int16_t));
+    return out_samples;
+}
+
+static int process_f32(audio_resampler_t *resampler, const float *in, int in_samples, float *out) {
+    int channels = resampler->channels;
+    int out_samples = 0;
+    uint64_t end = (uint64_t) in_samples << 32;
+    uint64_t position = resampler->position;
+    for (; position < end; position += resampler->step, out_samples++) {
+        uint32_t index = (uint32_t) (position >> 32);
+        float frac = (float) (position & (ONE - 1)) / (float) ONE;
+        const float *a = index == 0 ? resampler->last.f32 : &in[(index - 1) * channels];
+        const float *b = &in[index * channels];
+        for (int ch = 0; ch < channels; ch++) {
+            out[out_samples * channels + ch] = a[ch] + (b[ch] - a[ch]) * frac;
+        }
+    }
+    resampler->position = position - end;
+    memcpy(resampler->last.f32, &in[(in_samples - 1) * channels], channels * sizeof(float));
+    return out_samples;
+}
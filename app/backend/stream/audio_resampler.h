@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL.h>
+
+#define AUDIO_RESAMPLER_MAX_CHANNELS 8
+/** Maximum correction applied for clock drift, in ppm */
+#define AUDIO_RESAMPLER_MAX_PPM 500
+
+/**
+ * Linear interpolating resampler for small ratio changes, driven by a PI controller on sink backlog error.
+ *
+ * Correction is done in ppm, so the output can't be told apart from input by ear, but it's enough to keep the sink
+ * backlog flat when host and sink clocks drift apart.
+ */
+typedef struct audio_resampler_t {
+    int channels;
+    /** Samples are float instead of int16_t */
+    bool is_float;
+    /** Last input sample of previous frame */
+    union {
+        int16_t s16[AUDIO_RESAMPLER_MAX_CHANNELS];
+        float f32[AUDIO_RESAMPLER_MAX_CHANNELS];
+    } last;
+    /** Position of next output sample, in Q32.32 fixed point. 0 is the last sample of previous frame */
+    uint64_t position;
+    /** Input samples per output sample, in Q32.32 fixed point */
+    uint64_t step;
+    /** Current correction. Positive means fewer samples out */
+    int ppm;
+
+    /** Backlog error accumulated for current controller period */
+    int64_t error_sum_us;
+    int error_count;
+    Uint64 period_start_us;
+    /** Integral term of the controller, which converges to the clock drift */
+    int64_t integral_us;
+} audio_resampler_t;
+
+void audio_resampler_init(audio_resampler_t *resampler, int channels, bool is_float);
+
+/**
+ * Feed sink backlog error (backlog - target) to the drift controller. Correction is updated once per second.
+ */
+void audio_resampler_update(audio_resampler_t *resampler, Uint64 now_us, int64_t error_us);
+
+/**
+ * @param in Interleaved int16_t or float samples, depending on is_float
+ * @param out Needs room for at least in_samples + 1 samples
+ * @return Number of samples per channel written to out
+ */
+int audio_resampler_process(audio_resampler_t *resampler, const void *in, int in_samples, void *out);
@@ -0,0 +1,130 @@
+#include "hid_report_limiter.h"
+
+#include <string.h>
+
+static hid_report_limiter_device_t *find_device(hid_report_limiter_t *limiter, SDL_JoystickID which);
+
+static hid_report_limiter_device_t *add_device(hid_report_limiter_t *limiter, SDL_JoystickID which, Uint32 now);
+
+static void send_pending(hid_report_limiter_t *limiter, hid_report_limiter_device_t *device, Uint32 now);
+
+void hid_report_limiter_init(hid_report_limiter_t *limiter, int max_rate, hid_report_limiter_send_fn send,
+                             void *context) {
+    memset(limiter, 0, sizeof(hid_report_limiter_t));
+    if (max_rate > 0) {
+        // Timer resolution is 1ms, so rates above 1000Hz are the same as 1000Hz
+        limiter->interval_ms = SDL_max(1000 / max_rate, 1);
+    }
+    limiter->send = send;
+    limiter->context = context;
+}
+
+void hid_report_limiter_reset(hid_report_limiter_t *limiter) {
+    memset(limiter->devices, 0, sizeof(limiter->devices));
+    limiter->received = 0;
+    limiter->sent = 0;
+}
+
+void hid_report_limiter_handle_event(hid_report_limiter_t *limiter, const SDL_Event *event, Uint32 now) {
+    switch (event->type) {
+        case SDL_CONTROLLERAXISMOTION: {
+            limiter->received++;
+            hid_report_limiter_device_t *device = find_device(limiter, event->caxis.which);
+            if (device == NULL) {
+                device = add_device(limiter, event->caxis.which, now);
+            }
+            if (device == NULL || event->caxis.axis >= SDL_CONTROLLER_AXIS_MAX) {
+                // Out of slots, don't hold it back
+                limiter->sent++;
+                limiter->send(event, limiter->context);
+                return;
+            }
+            if (device->pending == 0) {
+                device->pending_since = event->caxis.timestamp;
+            }
+            device->last_axis = event->caxis.axis;
+            device->last_value = event->caxis.value;
+            device->pending |= 1u << event->caxis.axis;
+            if (!SDL_TICKS_PASSED(now, device->last_report + limiter->interval_ms)) {
+                return;
+            }
+            send_pending(limiter, device, now);
+            return;
+        }
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP: {
+            hid_report_limiter_device_t *device = find_device(limiter, event->cbutton.which);
+            if (device != NULL && device->pending != 0) {
+                send_pending(limiter, device, now);
+            }
+            break;
+        }
+        case SDL_CONTROLLERDEVICEREMOVED: {
+            hid_report_limiter_device_t *device = find_device(limiter, event->cdevice.which);
+            if (device != NULL) {
+                memset(device, 0, sizeof(hid_report_limiter_device_t));
+            }
+            break;
+        }
+    }
+    limiter->send(event, limiter->context);
+}
+
+Uint32 hid_report_limiter_flush(hid_report_limiter_t *limiter, Uint32 now) {
+    Uint32 next = UINT32_MAX;
+    for (int i = 0; i < HID_REPORT_LIMITER_MAX_DEVICES; i++) {
+        hid_report_limiter_device_t *device = &limiter->devices[i];
+        if (!device->used || device->pending == 0) {
+            continue;
+        }
+        Uint32 due = device->last_report + limiter->interval_ms;
+        if (SDL_TICKS_PASSED(now, due)) {
+            send_pending(limiter, device, now);
+        } else {
+            next = SDL_min(next, due - now);
+        }
+    }
+    return next;
+}
+
+static hid_report_limiter_device_t *find_device(hid_report_limiter_t *limiter, SDL_JoystickID which) {
+    for (int i = 0; i < HID_REPORT_LIMITER_MAX_DEVICES; i++) {
+        hid_report_limiter_device_t *device = &limiter->devices[i];
+        if (device->used && device->which == which) {
+            return device;
+        }
+    }
+    return NULL;
+}
+
+static hid_report_limiter_device_t *add_device(hid_report_limiter_t *limiter, SDL_JoystickID which, Uint32 now) {
+    for (int i = 0; i < HID_REPORT_LIMITER_MAX_DEVICES; i++) {
+        hid_report_limiter_device_t *device = &limiter->devices[i];
+        if (device->used) {
+            continue;
+        }
+        device->used = true;
+        device->which = which;
+        // Let the first motion through
+        device->last_report = now - limiter->interval_ms;
+        return device;
+    }
+    return NULL;
+}
+
+/**
+ * Report reads all axes from the controller, so one event covers every pending axis.
+ */
+static void send_pending(hid_report_limiter_t *limiter, hid_report_limiter_device_t *device, Uint32 now) {
+    SDL_Event event = {.caxis = {
+            .type = SDL_CONTROLLERAXISMOTION,
+            .timestamp = device->pending_since,
+            .which = device->which,
+            .axis = device->last_axis,
+            .value = device->last_value,
+    }};
+    limiter->sent++;
+    limiter->send(&event, limiter->context);
+    device->pending = 0;
+    device->last_report = now;
+}
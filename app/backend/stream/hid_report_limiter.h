@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL.h>
+
+#define HID_REPORT_LIMITER_MAX_DEVICES 8
+
+/**
+ * Limits how often axis reports of each game controller are sent to HID provider.
+ *
+ * HID provider builds every report from the full state of the controller, so one axis motion event sends all axes.
+ * Axis motion received within the report interval is held back, and once the interval has passed, a single event for
+ * the latest moved axis sends one report for all of them. Other controller events are sent immediately, right after
+ * pending axis report of the same controller, so their order is kept.
+ */
+typedef void (*hid_report_limiter_send_fn)(const SDL_Event *event, void *context);
+
+typedef struct hid_report_limiter_device_t {
+    bool used;
+    SDL_JoystickID which;
+    /** When axis motion was sent last time */
+    Uint32 last_report;
+    /** Bit mask of axes with values not sent yet */
+    Uint32 pending;
+    /** Latest moved axis and its value, sent as the event triggering the report */
+    Uint8 last_axis;
+    Sint16 last_value;
+    /** Timestamp of the oldest axis event not sent yet */
+    Uint32 pending_since;
+} hid_report_limiter_device_t;
+
+typedef struct hid_report_limiter_t {
+    /** 0 to send every axis motion immediately */
+    Uint32 interval_ms;
+    hid_report_limiter_send_fn send;
+    void *context;
+    hid_report_limiter_device_t devices[HID_REPORT_LIMITER_MAX_DEVICES];
+    /** Axis motion events received */
+    uint32_t received;
+    /** Axis reports sent, at most one per controller per interval */
+    uint32_t sent;
+} hid_report_limiter_t;
+
+/**
+ * @param max_rate Maximum number of axis reports per second for each controller, 0 for unlimited
+ */
+void hid_report_limiter_init(hid_report_limiter_t *limiter, int max_rate, hid_report_limiter_send_fn send,
+                             void *context);
+
+/**
+ * Drop all pending axis motion and counters.
+ */
+void hid_report_limiter_reset(hid_report_limiter_t *limiter);
+
+/**
+ * Send a game controller event, or defer it if it's axis motion within the report interval.
+ * @param now SDL_GetTicks()
+ */
+void hid_report_limiter_handle_event(hid_report_limiter_t *limiter, const SDL_Event *event, Uint32 now);
+
+/**
+ * Send pending axis reports which are due.
+ * @param now SDL_GetTicks()
+ * @return Milliseconds until next pending axis motion is due, or UINT32_MAX if nothing is pending
+ */
+Uint32 hid_report_limiter_flush(hid_report_limiter_t *limiter, Uint32 now);
@@ -0,0 +1,170 @@
+#include "input_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct input_trace_histogram_t {
+    SDL_atomic_t buckets[INPUT_TRACE_BUCKETS];
+    SDL_atomic_t count;
+    SDL_atomic_t max_us;
+} input_trace_histogram_t;
+
+struct input_trace_t {
+    input_trace_histogram_t histograms[INPUT_TRACE_CATEGORY_COUNT];
+};
+
+static int bucket_index(uint32_t latency_us);
+
+static uint32_t bucket_upper_bound(int index);
+
+static uint32_t percentile_us(const input_trace_histogram_t *histogram, uint32_t count, uint32_t percent);
+
+static void update_max(SDL_atomic_t *max, int value);
+
+static const char *category_names[INPUT_TRACE_CATEGORY_COUNT] = {
+        [INPUT_TRACE_KEYBOARD] = "Keyboard",
+        [INPUT_TRACE_MOUSE_MOTION] = "Mouse motion",
+        [INPUT_TRACE_MOUSE_BUTTON] = "Mouse button",
+        [INPUT_TRACE_MOUSE_WHEEL] = "Mouse wheel",
+        [INPUT_TRACE_GAMEPAD] = "Gamepad",
+};
+
+input_trace_t *input_trace_create() {
+    return calloc(1, sizeof(input_trace_t));
+}
+
+void input_trace_destroy(input_trace_t *trace) {
+    free(trace);
+}
+
+void input_trace_reset(input_trace_t *trace) {
+    for (int category = 0; category < INPUT_TRACE_CATEGORY_COUNT; category++) {
+        input_trace_histogram_t *histogram = &trace->histograms[category];
+        for (int i = 0; i < INPUT_TRACE_BUCKETS; i++) {
+            SDL_AtomicSet(&histogram->buckets[i], 0);
+        }
+        SDL_AtomicSet(&histogram->count, 0);
+        SDL_AtomicSet(&histogram->max_us, 0);
+    }
+}
+
+void input_trace_record_us(input_trace_t *trace, input_trace_category_t category, uint32_t latency_us) {
+    input_trace_histogram_t *histogram = &trace->histograms[category];
+    SDL_AtomicAdd(&histogram->buckets[bucket_index(latency_us)], 1);
+    SDL_AtomicAdd(&histogram->count, 1);
+    update_max(&histogram->max_us, latency_us > INT32_MAX ? INT32_MAX : (int) latency_us);
+}
+
+void input_trace_record_ticks(input_trace_t *trace, input_trace_category_t category, Uint32 timestamp) {
+    Uint32 now = SDL_GetTicks();
+    // Timestamp can be slightly ahead if it was taken from another clock source
+    Uint32 elapsed_ms = SDL_TICKS_PASSED(now, timestamp) ? now - timestamp : 0;
+    input_trace_record_us(trace, category, elapsed_ms > UINT32_MAX / 1000 ? UINT32_MAX : elapsed_ms * 1000);
+}
+
+void input_trace_get_summary(const input_trace_t *trace, input_trace_category_t category,
+                             input_trace_summary_t *summary) {
+    const input_trace_histogram_t *histogram = &trace->histograms[category];
+    summary->count = (uint32_t) SDL_AtomicGet((SDL_atomic_t *) &histogram->count);
+    summary->max_us = (uint32_t) SDL_AtomicGet((SDL_atomic_t *) &histogram->max_us);
+    summary->p50_us = SDL_min(percentile_us(histogram, summary->count, 50), summary->max_us);
+    summary->p99_us = SDL_min(percentile_us(histogram, summary->count, 99), summary->max_us);
+}
+
+size_t input_trace_format(const input_trace_t *trace, char *buf, size_t size) {
+    size_t len = 0;
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+    for (int category = 0; category < INPUT_TRACE_CATEGORY_COUNT && len < size; category++) {
+        input_trace_summary_t summary;
+        input_trace_get_summary(trace, category, &summary);
+        if (summary.count == 0) {
+            continue;
+        }
+        int written = snprintf(buf + len, size - len, "%s%s: %u, p50 %.1f ms, p99 %.1f ms, max %.1f ms",
+                               len > 0 ? "\n" : "", category_names[category], summary.count,
+                               summary.p50_us / 1000.0, summary.p99_us / 1000.0, summary.max_us / 1000.0);
+        if (written < 0) {
+            break;
+        }
+        len += (size_t) written;
+    }
+    return len < size ? len : size - 1;
+}
+
+bool input_trace_dump(const input_trace_t *trace, const char *path, const char *title) {
+    FILE *file = fopen(path, "a");
+    if (file == NULL) {
+        return false;
+    }
+    time_t now = time(NULL);
+    char time_str[32];
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(file, "# %s %s\n", time_str, title);
+    for (int category = 0; category < INPUT_TRACE_CATEGORY_COUNT; category++) {
+        input_trace_summary_t summary;
+        input_trace_get_summary(trace, category, &summary);
+        if (summary.count == 0) {
+            continue;
+        }
+        fprintf(file, "%s: count=%u p50=%uus p99=%uus max=%uus\n", category_names[category], summary.count,
+                summary.p50_us, summary.p99_us, summary.max_us);
+        const input_trace_histogram_t *histogram = &trace->histograms[category];
+        for (int i = 0; i < INPUT_TRACE_BUCKETS; i++) {
+            int count = SDL_AtomicGet((SDL_atomic_t *) &histogram->buckets[i]);
+            if (count == 0) {
+                continue;
+            }
+            fprintf(file, "  <%uus\t%d\n", bucket_upper_bound(i), count);
+        }
+    }
+    fputc('\n', file);
+    return fclose(file) == 0;
+}
+
+const char *input_trace_category_name(input_trace_category_t category) {
+    return category_names[category];
+}
+
+static int bucket_index(uint32_t latency_us) {
+    int index = 0;
+    while (latency_us > 0 && index < INPUT_TRACE_BUCKETS - 1) {
+        latency_us >>= 1;
+        index++;
+    }
+    return index;
+}
+
+static uint32_t bucket_upper_bound(int index) {
+    if (index >= INPUT_TRACE_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return 1u << index;
+}
+
+static uint32_t percentile_us(const input_trace_histogram_t *histogram, uint32_t count, uint32_t percent) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t target = (uint32_t) (((uint64_t) count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (int i = 0; i < INPUT_TRACE_BUCKETS; i++) {
+        seen += (uint32_t) SDL_AtomicGet((SDL_atomic_t *) &histogram->buckets[i]);
+        if (seen >= target) {
+            return bucket_upper_bound(i);
+        }
+    }
+    return bucket_upper_bound(INPUT_TRACE_BUCKETS - 1);
+}
+
+static void update_max(SDL_atomic_t *max, int value) {
+    int current;
+    do {
+        current = SDL_AtomicGet(max);
+        if (value <= current) {
+            return;
+        }
+    } while (!SDL_AtomicCAS(max, current, value));
+}
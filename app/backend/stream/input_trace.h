@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL.h>
+
+/**
+ * Histograms of time taken from an input event happening to it being sent to host.
+ *
+ * Recording is lock-free and can be done from any thread. Buckets are power of two microseconds. Latency measured from
+ * SDL event timestamps only has millisecond resolution.
+ */
+typedef struct input_trace_t input_trace_t;
+
+typedef enum input_trace_category_t {
+    INPUT_TRACE_KEYBOARD,
+    INPUT_TRACE_MOUSE_MOTION,
+    INPUT_TRACE_MOUSE_BUTTON,
+    INPUT_TRACE_MOUSE_WHEEL,
+    INPUT_TRACE_GAMEPAD,
+    INPUT_TRACE_CATEGORY_COUNT,
+} input_trace_category_t;
+
+/** Bucket 0 holds latency under 1us, bucket n holds [2^(n-1), 2^n) us, last bucket holds everything above */
+#define INPUT_TRACE_BUCKETS 24
+
+typedef struct input_trace_summary_t {
+    uint32_t count;
+    /** Upper bound of the bucket containing the percentile, capped at max_us */
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} input_trace_summary_t;
+
+input_trace_t *input_trace_create();
+
+void input_trace_destroy(input_trace_t *trace);
+
+/**
+ * Clear all histograms. Samples recorded at the same time may be partially lost.
+ */
+void input_trace_reset(input_trace_t *trace);
+
+void input_trace_record_us(input_trace_t *trace, input_trace_category_t category, uint32_t latency_us);
+
+/**
+ * Record an input sent just now.
+ * @param timestamp SDL_GetTicks() when the input happened, as in SDL event timestamps
+ */
+void input_trace_record_ticks(input_trace_t *trace, input_trace_category_t category, Uint32 timestamp);
+
+void input_trace_get_summary(const input_trace_t *trace, input_trace_category_t category,
+                             input_trace_summary_t *summary);
+
+/**
+ * Write one line of summary for each category which has samples.
+ * @return Length of text written, excluding terminating NUL
+ */
+size_t input_trace_format(const input_trace_t *trace, char *buf, size_t size);
+
+/**
+ * Append summaries and full histograms to a text file.
+ */
+bool input_trace_dump(const input_trace_t *trace, const char *path, const char *title);
+
+const char *input_trace_category_name(input_trace_category_t category);
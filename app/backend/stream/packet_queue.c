@@ -0,0 +1,123 @@
+#include "packet_queue.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct packet_queue_t {
+    packet_queue_slot_t *slots;
+    size_t depth;
+    /** Written by producer only */
+    SDL_atomic_t head;
+    /** Written by consumer only */
+    SDL_atomic_t tail;
+    /** Number of published packets */
+    SDL_sem *filled;
+    /** Number of free slots */
+    SDL_sem *vacant;
+    /** Consumer side only. Whether the slot at tail has been taken by packet_queue_peek */
+    bool peeked;
+
+    SDL_atomic_t pushed;
+    SDL_atomic_t overflows;
+    SDL_atomic_t high_water;
+};
+
+static void update_high_water(packet_queue_t *queue, int size);
+
+packet_queue_t *packet_queue_create(size_t depth) {
+    assert(depth > 0);
+    packet_queue_t *queue = calloc(1, sizeof(packet_queue_t));
+    queue->slots = calloc(depth, sizeof(packet_queue_slot_t));
+    queue->depth = depth;
+    queue->filled = SDL_CreateSemaphore(0);
+    queue->vacant = SDL_CreateSemaphore((Uint32) depth);
+    return queue;
+}
+
+void packet_queue_destroy(packet_queue_t *queue) {
+    for (size_t i = 0; i < queue->depth; i++) {
+        free(queue->slots[i].data);
+    }
+    SDL_DestroySemaphore(queue->filled);
+    SDL_DestroySemaphore(queue->vacant);
+    free(queue->slots);
+    free(queue);
+}
+
+bool packet_queue_push(packet_queue_t *queue, const unsigned char *data, size_t size, uint32_t flags,
+                       uint32_t timeout_ms) {
+    int acquired = timeout_ms > 0 ? SDL_SemWaitTimeout(queue->vacant, timeout_ms) : SDL_SemTryWait(queue->vacant);
+    if (acquired != 0) {
+        SDL_AtomicAdd(&queue->overflows, 1);
+        return false;
+    }
+    int head = SDL_AtomicGet(&queue->head);
+    packet_queue_slot_t *slot = &queue->slots[(unsigned int) head % queue->depth];
+    if (slot->capacity < size) {
+        unsigned char *grown = realloc(slot->data, size);
+        if (grown == NULL) {
+            SDL_SemPost(queue->vacant);
+            SDL_AtomicAdd(&queue->overflows, 1);
+            return false;
+        }
+        slot->data = grown;
+        slot->capacity = size;
+    }
+    memcpy(slot->data, data, size);
+    slot->size = size;
+    slot->flags = flags;
+    slot->timestamp = SDL_GetTicks();
+    slot->counter = SDL_GetPerformanceCounter();
+    SDL_AtomicSet(&queue->head, head + 1);
+    SDL_AtomicAdd(&queue->pushed, 1);
+    update_high_water(queue, head + 1 - SDL_AtomicGet(&queue->tail));
+    SDL_SemPost(queue->filled);
+    return true;
+}
+
+packet_queue_slot_t *packet_queue_peek(packet_queue_t *queue, uint32_t timeout_ms) {
+    int tail = SDL_AtomicGet(&queue->tail);
+    if (!queue->peeked) {
+        if (SDL_SemWaitTimeout(queue->filled, timeout_ms) != 0) {
+            return NULL;
+        }
+        if (SDL_AtomicGet(&queue->head) == tail) {
+            // Woken up by packet_queue_interrupt
+            return NULL;
+        }
+        queue->peeked = true;
+    }
+    return &queue->slots[(unsigned int) tail % queue->depth];
+}
+
+void packet_queue_pop(packet_queue_t *queue) {
+    assert(queue->peeked);
+    queue->peeked = false;
+    SDL_AtomicAdd(&queue->tail, 1);
+    SDL_SemPost(queue->vacant);
+}
+
+void packet_queue_interrupt(packet_queue_t *queue) {
+    SDL_SemPost(queue->filled);
+}
+
+size_t packet_queue_size(packet_queue_t *queue) {
+    return (size_t) (SDL_AtomicGet(&queue->head) - SDL_AtomicGet(&queue->tail));
+}
+
+void packet_queue_get_stats(packet_queue_t *queue, packet_queue_stats_t *stats) {
+    stats->pushed = SDL_AtomicGet(&queue->pushed);
+    stats->overflows = SDL_AtomicGet(&queue->overflows);
+    stats->high_water = SDL_AtomicGet(&queue->high_water);
+}
+
+static void update_high_water(packet_queue_t *queue, int size) {
+    int current;
+    do {
+        current = SDL_AtomicGet(&queue->high_water);
+        if (size <= current) {
+            return;
+        }
+    } while (!SDL_AtomicCAS(&queue->high_water, current, size));
+}
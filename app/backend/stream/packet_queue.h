@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL.h>
+
+/**
+ * A bounded single-producer/single-consumer ring of packet slots.
+ *
+ * The producer copies packet data into a slot it owns, and publishes it. The consumer peeks the oldest slot, uses it
+ * in place, then pops it to hand the slot back. Slot buffers are reused and only grow, so steady-state streaming
+ * doesn't allocate.
+ */
+typedef struct packet_queue_t packet_queue_t;
+
+typedef struct packet_queue_slot_t {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    uint32_t flags;
+    /** SDL_GetTicks() when the packet was pushed */
+    Uint32 timestamp;
+    /** SDL_GetPerformanceCounter() when the packet was pushed, for finer timing */
+    Uint64 counter;
+} packet_queue_slot_t;
+
+typedef struct packet_queue_stats_t {
+    uint32_t pushed;
+    /** Number of packets rejected because the queue was full */
+    uint32_t overflows;
+    /** Maximum number of packets queued at the same time */
+    uint32_t high_water;
+} packet_queue_stats_t;
+
+packet_queue_t *packet_queue_create(size_t depth);
+
+void packet_queue_destroy(packet_queue_t *queue);
+
+/**
+ * Copy a packet into the queue. Producer side only.
+ * @param timeout_ms How long to wait for a vacant slot. 0 to fail immediately if the queue is full.
+ * @return false if the queue is still full after timeout
+ */
+bool packet_queue_push(packet_queue_t *queue, const unsigned char *data, size_t size, uint32_t flags,
+                       uint32_t timeout_ms);
+
+/**
+ * Get the oldest packet without removing it. Consumer side only.
+ * @param timeout_ms How long to wait for a packet. SDL_MUTEX_MAXWAIT to wait forever.
+ * @return NULL if timed out, or interrupted by packet_queue_interrupt
+ */
+packet_queue_slot_t *packet_queue_peek(packet_queue_t *queue, uint32_t timeout_ms);
+
+/**
+ * Release the slot returned by last packet_queue_peek. Consumer side only.
+ */
+void packet_queue_pop(packet_queue_t *queue);
+
+/**
+ * Wake up a consumer blocking in packet_queue_peek.
+ */
+void packet_queue_interrupt(packet_queue_t *queue);
+
+size_t packet_queue_size(packet_queue_t *queue);
+
+void packet_queue_get_stats(packet_queue_t *queue, packet_queue_stats_t *stats);
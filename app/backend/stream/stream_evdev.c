@@ -0,0 +1,668 @@
+#include "stream_evdev.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <time.h>
+
+#include <SDL.h>
+
+#include "logging.h"
+
+#define EVDEV_MAX_DEVICES 16
+#define EVDEV_READ_BATCH 64
+
+#define BITS_PER_LONG (sizeof(unsigned long) * 8)
+#define NBITS(x) ((((x) - 1) / BITS_PER_LONG) + 1)
+#define TEST_BIT(bit, array) (((array)[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1)
+
+typedef struct evdev_device_t {
+    /** -1 if the slot is free */
+    int fd;
+    /** Node name under /dev/input, like event3 */
+    char node[32];
+    char name[64];
+    bool keyboard;
+    /** Only set when relmouse is enabled */
+    bool mouse;
+} evdev_device_t;
+
+struct stream_evdev_t {
+    IHS_Session *session;
+    bool relmouse;
+    /** Set when every keyboard connected is read here */
+    SDL_atomic_t all_keyboards;
+    /** Set when every mouse connected is read here */
+    SDL_atomic_t all_mice;
+    int epoll_fd;
+    /** Written by stream_evdev_stop to wake up the input thread */
+    int stop_fd;
+    /** Watches /dev/input for devices added, removed, or having permission changed */
+    int inotify_fd;
+    evdev_device_t devices[EVDEV_MAX_DEVICES];
+    /** Number of device slots ever used, including freed ones */
+    int num_devices;
+    SDL_Thread *thread;
+    SDL_atomic_t forwarding;
+    input_trace_t *trace;
+    /** Input thread only. Relative movement until next SYN_REPORT */
+    int dx, dy;
+    /** Input thread only. Time of the first relative movement until next SYN_REPORT */
+    struct timeval motion_time;
+};
+
+static void evdev_free(stream_evdev_t *evdev);
+
+static void scan_devices(stream_evdev_t *evdev);
+
+static evdev_device_t *find_device(stream_evdev_t *evdev, const char *node);
+
+static bool open_device(stream_evdev_t *evdev, const char *node, bool *keyboard, bool *mouse);
+
+static evdev_device_t *alloc_device(stream_evdev_t *evdev);
+
+static bool probe_device(int fd, bool *keyboard, bool *mouse);
+
+static bool probe_sysfs(const char *node, bool *keyboard, bool *mouse);
+
+static bool read_sysfs_bits(const char *node, const char *type, unsigned long *bits, size_t words);
+
+static bool classify_device(const unsigned long *key_bits, const unsigned long *rel_bits, bool *keyboard, bool *mouse);
+
+static void close_device(stream_evdev_t *evdev, evdev_device_t *device);
+
+static int input_thread(void *arg);
+
+static void handle_input_event(stream_evdev_t *evdev, const evdev_device_t *device, const struct input_event *event);
+
+static void flush_motion(stream_evdev_t *evdev);
+
+static void trace_event(stream_evdev_t *evdev, input_trace_category_t category, const struct timeval *time);
+
+static SDL_Scancode keycode_to_scancode(unsigned int code);
+
+static const SDL_Scancode keycode_table[] = {
+        [KEY_ESC] = SDL_SCANCODE_ESCAPE,
+        [KEY_1] = SDL_SCANCODE_1,
+        [KEY_2] = SDL_SCANCODE_2,
+        [KEY_3] = SDL_SCANCODE_3,
+        [KEY_4] = SDL_SCANCODE_4,
+        [KEY_5] = SDL_SCANCODE_5,
+        [KEY_6] = SDL_SCANCODE_6,
+        [KEY_7] = SDL_SCANCODE_7,
+        [KEY_8] = SDL_SCANCODE_8,
+        [KEY_9] = SDL_SCANCODE_9,
+        [KEY_0] = SDL_SCANCODE_0,
+        [KEY_MINUS] = SDL_SCANCODE_MINUS,
+        [KEY_EQUAL] = SDL_SCANCODE_EQUALS,
+        [KEY_BACKSPACE] = SDL_SCANCODE_BACKSPACE,
+        [KEY_TAB] = SDL_SCANCODE_TAB,
+        [KEY_Q] = SDL_SCANCODE_Q,
+        [KEY_W] = SDL_SCANCODE_W,
+        [KEY_E] = SDL_SCANCODE_E,
+        [KEY_R] = SDL_SCANCODE_R,
+        [KEY_T] = SDL_SCANCODE_T,
+        [KEY_Y] = SDL_SCANCODE_Y,
+        [KEY_U] = SDL_SCANCODE_U,
+        [KEY_I] = SDL_SCANCODE_I,
+        [KEY_O] = SDL_SCANCODE_O,
+        [KEY_P] = SDL_SCANCODE_P,
+        [KEY_LEFTBRACE] = SDL_SCANCODE_LEFTBRACKET,
+        [KEY_RIGHTBRACE] = SDL_SCANCODE_RIGHTBRACKET,
+        [KEY_ENTER] = SDL_SCANCODE_RETURN,
+        [KEY_LEFTCTRL] = SDL_SCANCODE_LCTRL,
+        [KEY_A] = SDL_SCANCODE_A,
+        [KEY_S] = SDL_SCANCODE_S,
+        [KEY_D] = SDL_SCANCODE_D,
+        [KEY_F] = SDL_SCANCODE_F,
+        [KEY_G] = SDL_SCANCODE_G,
+        [KEY_H] = SDL_SCANCODE_H,
+        [KEY_J] = SDL_SCANCODE_J,
+        [KEY_K] = SDL_SCANCODE_K,
+        [KEY_L] = SDL_SCANCODE_L,
+        [KEY_SEMICOLON] = SDL_SCANCODE_SEMICOLON,
+        [KEY_APOSTROPHE] = SDL_SCANCODE_APOSTROPHE,
+        [KEY_GRAVE] = SDL_SCANCODE_GRAVE,
+        [KEY_LEFTSHIFT] = SDL_SCANCODE_LSHIFT,
+        [KEY_BACKSLASH] = SDL_SCANCODE_BACKSLASH,
+        [KEY_Z] = SDL_SCANCODE_Z,
+        [KEY_X] = SDL_SCANCODE_X,
+        [KEY_C] = SDL_SCANCODE_C,
+        [KEY_V] = SDL_SCANCODE_V,
+        [KEY_B] = SDL_SCANCODE_B,
+        [KEY_N] = SDL_SCANCODE_N,
+        [KEY_M] = SDL_SCANCODE_M,
+        [KEY_COMMA] = SDL_SCANCODE_COMMA,
+        [KEY_DOT] = SDL_SCANCODE_PERIOD,
+        [KEY_SLASH] = SDL_SCANCODE_SLASH,
+        [KEY_RIGHTSHIFT] = SDL_SCANCODE_RSHIFT,
+        [KEY_KPASTERISK] = SDL_SCANCODE_KP_MULTIPLY,
+        [KEY_LEFTALT] = SDL_SCANCODE_LALT,
+        [KEY_SPACE] = SDL_SCANCODE_SPACE,
+        [KEY_CAPSLOCK] = SDL_SCANCODE_CAPSLOCK,
+        [KEY_F1] = SDL_SCANCODE_F1,
+        [KEY_F2] = SDL_SCANCODE_F2,
+        [KEY_F3] = SDL_SCANCODE_F3,
+        [KEY_F4] = SDL_SCANCODE_F4,
+        [KEY_F5] = SDL_SCANCODE_F5,
+        [KEY_F6] = SDL_SCANCODE_F6,
+        [KEY_F7] = SDL_SCANCODE_F7,
+        [KEY_F8] = SDL_SCANCODE_F8,
+        [KEY_F9] = SDL_SCANCODE_F9,
+        [KEY_F10] = SDL_SCANCODE_F10,
+        [KEY_NUMLOCK] = SDL_SCANCODE_NUMLOCKCLEAR,
+        [KEY_SCROLLLOCK] = SDL_SCANCODE_SCROLLLOCK,
+        [KEY_KP7] = SDL_SCANCODE_KP_7,
+        [KEY_KP8] = SDL_SCANCODE_KP_8,
+        [KEY_KP9] = SDL_SCANCODE_KP_9,
+        [KEY_KPMINUS] = SDL_SCANCODE_KP_MINUS,
+        [KEY_KP4] = SDL_SCANCODE_KP_4,
+        [KEY_KP5] = SDL_SCANCODE_KP_5,
+        [KEY_KP6] = SDL_SCANCODE_KP_6,
+        [KEY_KPPLUS] = SDL_SCANCODE_KP_PLUS,
+        [KEY_KP1] = SDL_SCANCODE_KP_1,
+        [KEY_KP2] = SDL_SCANCODE_KP_2,
+        [KEY_KP3] = SDL_SCANCODE_KP_3,
+        [KEY_KP0] = SDL_SCANCODE_KP_0,
+        [KEY_KPDOT] = SDL_SCANCODE_KP_PERIOD,
+        [KEY_ZENKAKUHANKAKU] = SDL_SCANCODE_LANG5,
+        [KEY_102ND] = SDL_SCANCODE_NONUSBACKSLASH,
+        [KEY_F11] = SDL_SCANCODE_F11,
+        [KEY_F12] = SDL_SCANCODE_F12,
+        [KEY_RO] = SDL_SCANCODE_INTERNATIONAL1,
+        [KEY_KATAKANA] = SDL_SCANCODE_LANG3,
+        [KEY_HIRAGANA] = SDL_SCANCODE_LANG4,
+        [KEY_HENKAN] = SDL_SCANCODE_INTERNATIONAL4,
+        [KEY_KATAKANAHIRAGANA] = SDL_SCANCODE_INTERNATIONAL2,
+        [KEY_MUHENKAN] = SDL_SCANCODE_INTERNATIONAL5,
+        [KEY_KPENTER] = SDL_SCANCODE_KP_ENTER,
+        [KEY_RIGHTCTRL] = SDL_SCANCODE_RCTRL,
+        [KEY_KPSLASH] = SDL_SCANCODE_KP_DIVIDE,
+        [KEY_SYSRQ] = SDL_SCANCODE_PRINTSCREEN,
+        [KEY_RIGHTALT] = SDL_SCANCODE_RALT,
+        [KEY_HOME] = SDL_SCANCODE_HOME,
+        [KEY_UP] = SDL_SCANCODE_UP,
+        [KEY_PAGEUP] = SDL_SCANCODE_PAGEUP,
+        [KEY_LEFT] = SDL_SCANCODE_LEFT,
+        [KEY_RIGHT] = SDL_SCANCODE_RIGHT,
+        [KEY_END] = SDL_SCANCODE_END,
+        [KEY_DOWN] = SDL_SCANCODE_DOWN,
+        [KEY_PAGEDOWN] = SDL_SCANCODE_PAGEDOWN,
+        [KEY_INSERT] = SDL_SCANCODE_INSERT,
+        [KEY_DELETE] = SDL_SCANCODE_DELETE,
+        [KEY_MUTE] = SDL_SCANCODE_MUTE,
+        [KEY_VOLUMEDOWN] = SDL_SCANCODE_VOLUMEDOWN,
+        [KEY_VOLUMEUP] = SDL_SCANCODE_VOLUMEUP,
+        [KEY_POWER] = SDL_SCANCODE_POWER,
+        [KEY_KPEQUAL] = SDL_SCANCODE_KP_EQUALS,
+        [KEY_KPPLUSMINUS] = SDL_SCANCODE_KP_PLUSMINUS,
+        [KEY_PAUSE] = SDL_SCANCODE_PAUSE,
+        [KEY_KPCOMMA] = SDL_SCANCODE_KP_COMMA,
+        [KEY_HANGEUL] = SDL_SCANCODE_LANG1,
+        [KEY_HANJA] = SDL_SCANCODE_LANG2,
+        [KEY_YEN] = SDL_SCANCODE_INTERNATIONAL3,
+        [KEY_LEFTMETA] = SDL_SCANCODE_LGUI,
+        [KEY_RIGHTMETA] = SDL_SCANCODE_RGUI,
+        [KEY_COMPOSE] = SDL_SCANCODE_APPLICATION,
+        [KEY_F13] = SDL_SCANCODE_F13,
+        [KEY_F14] = SDL_SCANCODE_F14,
+        [KEY_F15] = SDL_SCANCODE_F15,
+        [KEY_F16] = SDL_SCANCODE_F16,
+        [KEY_F17] = SDL_SCANCODE_F17,
+        [KEY_F18] = SDL_SCANCODE_F18,
+        [KEY_F19] = SDL_SCANCODE_F19,
+        [KEY_F20] = SDL_SCANCODE_F20,
+        [KEY_F21] = SDL_SCANCODE_F21,
+        [KEY_F22] = SDL_SCANCODE_F22,
+        [KEY_F23] = SDL_SCANCODE_F23,
+        [KEY_F24] = SDL_SCANCODE_F24,
+};
+
+stream_evdev_t *stream_evdev_start(IHS_Session *session, bool relmouse, input_trace_t *trace) {
+    stream_evdev_t *evdev = calloc(1, sizeof(stream_evdev_t));
+    evdev->session = session;
+    evdev->relmouse = relmouse;
+    evdev->trace = trace;
+    evdev->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    evdev->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    evdev->inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    // Stop event is told apart from devices by NULL data, and hotplug notification by data pointing to evdev itself
+    struct epoll_event stop_ev = {.events = EPOLLIN, .data.ptr = NULL};
+    struct epoll_event hotplug_ev = {.events = EPOLLIN, .data.ptr = evdev};
+    if (evdev->epoll_fd < 0 || evdev->stop_fd < 0 || evdev->inotify_fd < 0 ||
+        epoll_ctl(evdev->epoll_fd, EPOLL_CTL_ADD, evdev->stop_fd, &stop_ev) != 0 ||
+        epoll_ctl(evdev->epoll_fd, EPOLL_CTL_ADD, evdev->inotify_fd, &hotplug_ev) != 0) {
+        commons_log_error("Evdev", "Failed to set up epoll: %s", strerror(errno));
+        evdev_free(evdev);
+        return NULL;
+    }
+    if (inotify_add_watch(evdev->inotify_fd, "/dev/input", IN_CREATE | IN_DELETE | IN_ATTRIB) < 0) {
+        commons_log_warn("Evdev", "Can't watch /dev/input: %s", strerror(errno));
+        evdev_free(evdev);
+        return NULL;
+    }
+    // Watch is set up first, so devices added during the scan won't be missed
+    scan_devices(evdev);
+    SDL_AtomicSet(&evdev->forwarding, 1);
+    evdev->thread = SDL_CreateThread(input_thread, "evdev-input", evdev);
+    if (evdev->thread == NULL) {
+        commons_log_error("Evdev", "Failed to start input thread: %s", SDL_GetError());
+        evdev_free(evdev);
+        return NULL;
+    }
+    return evdev;
+}
+
+void stream_evdev_stop(stream_evdev_t *evdev) {
+    uint64_t value = 1;
+    if (write(evdev->stop_fd, &value, sizeof(value)) != sizeof(value)) {
+        commons_log_error("Evdev", "Failed to signal input thread: %s", strerror(errno));
+    }
+    SDL_WaitThread(evdev->thread, NULL);
+    evdev_free(evdev);
+}
+
+void stream_evdev_set_forwarding(stream_evdev_t *evdev, bool forwarding) {
+    SDL_AtomicSet(&evdev->forwarding, forwarding);
+}
+
+bool stream_evdev_reads_all_keyboards(stream_evdev_t *evdev) {
+    return SDL_AtomicGet(&evdev->all_keyboards) != 0;
+}
+
+bool stream_evdev_reads_all_mice(stream_evdev_t *evdev) {
+    return SDL_AtomicGet(&evdev->all_mice) != 0;
+}
+
+static void evdev_free(stream_evdev_t *evdev) {
+    for (int i = 0; i < evdev->num_devices; i++) {
+        if (evdev->devices[i].fd >= 0) {
+            close(evdev->devices[i].fd);
+        }
+    }
+    if (evdev->inotify_fd >= 0) {
+        close(evdev->inotify_fd);
+    }
+    if (evdev->stop_fd >= 0) {
+        close(evdev->stop_fd);
+    }
+    if (evdev->epoll_fd >= 0) {
+        close(evdev->epoll_fd);
+    }
+    free(evdev);
+}
+
+/**
+ * Open devices not opened yet, and count keyboards and mice which can't be read here. SDL keyboard and mouse events
+ * don't tell which device they came from, so SDL input is only skipped when every device of the kind is read here.
+ */
+static void scan_devices(stream_evdev_t *evdev) {
+    DIR *dir = opendir("/dev/input");
+    if (dir == NULL) {
+        commons_log_warn("Evdev", "Can't open /dev/input: %s", strerror(errno));
+        return;
+    }
+    int keyboards = 0, mice = 0, missed_keyboards = 0, missed_mice = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "event", 5) != 0) {
+            continue;
+        }
+        bool keyboard = false, mouse = false;
+        const evdev_device_t *device = find_device(evdev, entry->d_name);
+        if (device != NULL) {
+            keyboard = device->keyboard;
+            mouse = device->mouse;
+        } else if (!open_device(evdev, entry->d_name, &keyboard, &mouse)) {
+            // Not readable, so its input only comes from SDL
+            missed_keyboards += keyboard;
+            missed_mice += mouse;
+            continue;
+        }
+        keyboards += keyboard;
+        mice += mouse;
+    }
+    closedir(dir);
+    int all_keyboards = keyboards > 0 && missed_keyboards == 0;
+    int all_mice = mice > 0 && missed_mice == 0;
+    bool changed = SDL_AtomicSet(&evdev->all_keyboards, all_keyboards) != all_keyboards;
+    changed |= SDL_AtomicSet(&evdev->all_mice, all_mice) != all_mice;
+    if (changed) {
+        commons_log_info("Evdev", "Reading %d/%d keyboards, %d/%d mice", keyboards, keyboards + missed_keyboards,
+                         mice, mice + missed_mice);
+    }
+}
+
+static evdev_device_t *find_device(stream_evdev_t *evdev, const char *node) {
+    for (int i = 0; i < evdev->num_devices; i++) {
+        evdev_device_t *device = &evdev->devices[i];
+        if (device->fd >= 0 && strcmp(device->node, node) == 0) {
+            return device;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @param keyboard Set if the node is a keyboard, even when it couldn't be opened
+ * @param mouse Set if the node is a mouse to be read here, even when it couldn't be opened
+ * @return Whether the device is being read
+ */
+static bool open_device(stream_evdev_t *evdev, const char *node, bool *keyboard, bool *mouse) {
+    char path[300];
+    snprintf(path, sizeof(path), "/dev/input/%s", node);
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    int open_error = errno;
+    bool probed = fd >= 0 ? probe_device(fd, keyboard, mouse) : probe_sysfs(node, keyboard, mouse);
+    // Absolute mouse movement is mapped from SDL, so mice are left to SDL entirely to keep clicks after movement
+    *mouse = *mouse && evdev->relmouse;
+    if (!probed || !(*keyboard || *mouse)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    if (fd < 0) {
+        commons_log_debug("Evdev", "Can't open %s: %s", path, strerror(open_error));
+        return false;
+    }
+    evdev_device_t *device = alloc_device(evdev);
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = device};
+    if (device == NULL || epoll_ctl(evdev->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        commons_log_warn("Evdev", "Can't watch %s: %s", path, device == NULL ? "too many devices" : strerror(errno));
+        close(fd);
+        return false;
+    }
+    // Event timestamps are compared against CLOCK_MONOTONIC when tracing latency
+    int clock_id = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clock_id);
+    device->fd = fd;
+    device->keyboard = *keyboard;
+    device->mouse = *mouse;
+    snprintf(device->node, sizeof(device->node), "%s", node);
+    if (ioctl(fd, EVIOCGNAME(sizeof(device->name)), device->name) < 0) {
+        snprintf(device->name, sizeof(device->name), "%s", node);
+    }
+    commons_log_info("Evdev", "Reading %s (%s)%s%s", device->name, path, *keyboard ? " keyboard" : "",
+                     *mouse ? " mouse" : "");
+    return true;
+}
+
+static evdev_device_t *alloc_device(stream_evdev_t *evdev) {
+    for (int i = 0; i < evdev->num_devices; i++) {
+        if (evdev->devices[i].fd < 0) {
+            return &evdev->devices[i];
+        }
+    }
+    if (evdev->num_devices == EVDEV_MAX_DEVICES) {
+        return NULL;
+    }
+    evdev_device_t *device = &evdev->devices[evdev->num_devices++];
+    device->fd = -1;
+    return device;
+}
+
+static bool probe_device(int fd, bool *keyboard, bool *mouse) {
+    unsigned long ev_bits[NBITS(EV_MAX + 1)] = {0};
+    unsigned long key_bits[NBITS(KEY_MAX + 1)] = {0};
+    unsigned long rel_bits[NBITS(REL_MAX + 1)] = {0};
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(ev_bits)), ev_bits) < 0) {
+        return false;
+    }
+    if (TEST_BIT(EV_KEY, ev_bits)) {
+        ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits);
+    }
+    if (TEST_BIT(EV_REL, ev_bits)) {
+        ioctl(fd, EVIOCGBIT(EV_REL, sizeof(rel_bits)), rel_bits);
+    }
+    return classify_device(key_bits, rel_bits, keyboard, mouse);
+}
+
+/**
+ * Capabilities in sysfs are readable even when the device node isn't.
+ */
+static bool probe_sysfs(const char *node, bool *keyboard, bool *mouse) {
+    unsigned long key_bits[NBITS(KEY_MAX + 1)] = {0};
+    unsigned long rel_bits[NBITS(REL_MAX + 1)] = {0};
+    if (!read_sysfs_bits(node, "key", key_bits, NBITS(KEY_MAX + 1))) {
+        return false;
+    }
+    read_sysfs_bits(node, "rel", rel_bits, NBITS(REL_MAX + 1));
+    return classify_device(key_bits, rel_bits, keyboard, mouse);
+}
+
+/**
+ * Bitmaps are printed as hex words separated by spaces, most significant first.
+ */
+static bool read_sysfs_bits(const char *node, const char *type, unsigned long *bits, size_t words) {
+    char path[300];
+    snprintf(path, sizeof(path), "/sys/class/input/%s/device/capabilities/%s", node, type);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+    char line[1024];
+    bool ok = fgets(line, sizeof(line), file) != NULL;
+    fclose(file);
+    if (!ok) {
+        return false;
+    }
+    char *tokens[NBITS(KEY_MAX + 1)];
+    size_t count = 0;
+    char *saveptr = NULL;
+    for (char *token = strtok_r(line, " \n", &saveptr); token != NULL && count < words;
+         token = strtok_r(NULL, " \n", &saveptr)) {
+        tokens[count++] = token;
+    }
+    for (size_t i = 0; i < count; i++) {
+        bits[i] = strtoul(tokens[count - 1 - i], NULL, 16);
+    }
+    return true;
+}
+
+/**
+ * Only keyboards and mice are taken. Gamepads are left to SDL game controller and HID provider.
+ */
+static bool classify_device(const unsigned long *key_bits, const unsigned long *rel_bits, bool *keyboard, bool *mouse) {
+    if (TEST_BIT(BTN_GAMEPAD, key_bits) || TEST_BIT(BTN_JOYSTICK, key_bits)) {
+        return false;
+    }
+    *keyboard = TEST_BIT(KEY_A, key_bits) && TEST_BIT(KEY_SPACE, key_bits) && TEST_BIT(KEY_ENTER, key_bits);
+    *mouse = TEST_BIT(BTN_LEFT, key_bits) && TEST_BIT(REL_X, rel_bits) && TEST_BIT(REL_Y, rel_bits);
+    return true;
+}
+
+static void close_device(stream_evdev_t *evdev, evdev_device_t *device) {
+    epoll_ctl(evdev->epoll_fd, EPOLL_CTL_DEL, device->fd, NULL);
+    close(device->fd);
+    device->fd = -1;
+}
+
+static int input_thread(void *arg) {
+    stream_evdev_t *evdev = arg;
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+    struct epoll_event events[EVDEV_MAX_DEVICES + 2];
+    struct input_event buf[EVDEV_READ_BATCH];
+    for (;;) {
+        int count = epoll_wait(evdev->epoll_fd, events, EVDEV_MAX_DEVICES + 2, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            commons_log_error("Evdev", "epoll_wait failed: %s", strerror(errno));
+            return -1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == NULL) {
+                // Stop requested
+                return 0;
+            }
+            if (events[i].data.ptr == evdev) {
+                // Notifications are only used as a trigger, drain them and look at /dev/input again
+                while (read(evdev->inotify_fd, buf, sizeof(buf)) > 0) {
+                }
+                scan_devices(evdev);
+                continue;
+            }
+            evdev_device_t *device = events[i].data.ptr;
+            if (device->fd < 0) {
+                // Closed while handling earlier events of this batch
+                continue;
+            }
+            ssize_t size = read(device->fd, buf, sizeof(buf));
+            if (size < 0) {
+                if (errno == EAGAIN || errno == EINTR) {
+                    continue;
+                }
+                commons_log_info("Evdev", "%s removed: %s", device->name, strerror(errno));
+                close_device(evdev, device);
+                scan_devices(evdev);
+                continue;
+            }
+            for (size_t j = 0; j < (size_t) size / sizeof(struct input_event); j++) {
+                handle_input_event(evdev, device, &buf[j]);
+            }
+        }
+    }
+}
+
+static void handle_input_event(stream_evdev_t *evdev, const evdev_device_t *device, const struct input_event *event) {
+    if (!SDL_AtomicGet(&evdev->forwarding)) {
+        evdev->dx = 0;
+        evdev->dy = 0;
+        return;
+    }
+    switch (event->type) {
+        case EV_SYN: {
+            if (event->code == SYN_REPORT) {
+                flush_motion(evdev);
+            } else if (event->code == SYN_DROPPED) {
+                evdev->dx = 0;
+                evdev->dy = 0;
+            }
+            break;
+        }
+        case EV_REL: {
+            if (!device->mouse) {
+                break;
+            }
+            switch (event->code) {
+                case REL_X:
+                case REL_Y:
+                    if (evdev->dx == 0 && evdev->dy == 0) {
+                        evdev->motion_time = event->time;
+                    }
+                    if (event->code == REL_X) {
+                        evdev->dx += event->value;
+                    } else {
+                        evdev->dy += event->value;
+                    }
+                    break;
+                case REL_WHEEL:
+                    flush_motion(evdev);
+                    IHS_SessionSendMouseWheel(evdev->session, event->value > 0 ? IHS_MOUSE_WHEEL_UP
+                                                                               : IHS_MOUSE_WHEEL_DOWN);
+                    trace_event(evdev, INPUT_TRACE_MOUSE_WHEEL, &event->time);
+                    break;
+                case REL_HWHEEL:
+                    flush_motion(evdev);
+                    IHS_SessionSendMouseWheel(evdev->session, event->value > 0 ? IHS_MOUSE_WHEEL_RIGHT
+                                                                               : IHS_MOUSE_WHEEL_LEFT);
+                    trace_event(evdev, INPUT_TRACE_MOUSE_WHEEL, &event->time);
+                    break;
+            }
+            break;
+        }
+        case EV_KEY: {
+            IHS_StreamInputMouseButton button = 0;
+            switch (event->code) {
+                case BTN_LEFT:
+                    button = IHS_MOUSE_BUTTON_LEFT;
+                    break;
+                case BTN_RIGHT:
+                    button = IHS_MOUSE_BUTTON_RIGHT;
+                    break;
+                case BTN_MIDDLE:
+                    button = IHS_MOUSE_BUTTON_MIDDLE;
+                    break;
+                case BTN_SIDE:
+                    button = IHS_MOUSE_BUTTON_X1;
+                    break;
+                case BTN_EXTRA:
+                    button = IHS_MOUSE_BUTTON_X2;
+                    break;
+            }
+            if (button != 0) {
+                if (!device->mouse) {
+                    break;
+                }
+                flush_motion(evdev);
+                if (event->value == 0) {
+                    IHS_SessionSendMouseUp(evdev->session, button);
+                } else if (event->value == 1) {
+                    IHS_SessionSendMouseDown(evdev->session, button);
+                }
+                trace_event(evdev, INPUT_TRACE_MOUSE_BUTTON, &event->time);
+                break;
+            }
+            if (!device->keyboard) {
+                break;
+            }
+            SDL_Scancode scancode = keycode_to_scancode(event->code);
+            if (scancode == SDL_SCANCODE_UNKNOWN || scancode == SDL_SCANCODE_ESCAPE) {
+                // Escape opens overlay, and is handled by SDL
+                break;
+            }
+            // Value 2 is auto repeat, which is sent as key down like SDL does
+            if (event->value == 0) {
+                IHS_SessionSendKeyUp(evdev->session, scancode);
+            } else {
+                IHS_SessionSendKeyDown(evdev->session, scancode);
+            }
+            trace_event(evdev, INPUT_TRACE_KEYBOARD, &event->time);
+            break;
+        }
+    }
+}
+
+static void flush_motion(stream_evdev_t *evdev) {
+    if (evdev->dx == 0 && evdev->dy == 0) {
+        return;
+    }
+    IHS_SessionSendMouseMovement(evdev->session, evdev->dx, evdev->dy);
+    trace_event(evdev, INPUT_TRACE_MOUSE_MOTION, &evdev->motion_time);
+    evdev->dx = 0;
+    evdev->dy = 0;
+}
+
+static void trace_event(stream_evdev_t *evdev, input_trace_category_t category, const struct timeval *time) {
+    if (evdev->trace == NULL) {
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed_us = ((int64_t) now.tv_sec - time->tv_sec) * 1000000 + now.tv_nsec / 1000 - time->tv_usec;
+    if (elapsed_us < 0) {
+        elapsed_us = 0;
+    } else if (elapsed_us > UINT32_MAX) {
+        elapsed_us = UINT32_MAX;
+    }
+    input_trace_record_us(evdev->trace, category, (uint32_t) elapsed_us);
+}
+
+static SDL_Scancode keycode_to_scancode(unsigned int code) {
+    if (code >= sizeof(keycode_table) / sizeof(keycode_table[0])) {
+        return SDL_SCANCODE_UNKNOWN;
+    }
+    return keycode_table[code];
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "ihslib.h"
+
+#include "input_trace.h"
+
+/**
+ * Reads keyboards and mice from /dev/input in a dedicated thread, and sends their input to host right away, instead of
+ * waiting for the main loop to pick the events up from SDL. Devices plugged in later are picked up too.
+ *
+ * SDL still receives the same events, and keeps handling them for the UI. SDL events don't tell which device they came
+ * from, so stream input should only skip them when every keyboard, or every mouse, is read here. Escape key is left
+ * to SDL for opening the overlay.
+ */
+typedef struct stream_evdev_t stream_evdev_t;
+
+/**
+ * Open input devices and start the input thread.
+ * @param relmouse Whether mouse movement should be sent as relative motion. Mice are left to SDL otherwise, so clicks
+ *                 won't overtake the absolute movement before them.
+ * @param trace Records latency from kernel event timestamps, can be NULL
+ * @return NULL if /dev/input can't be watched
+ */
+stream_evdev_t *stream_evdev_start(IHS_Session *session, bool relmouse, input_trace_t *trace);
+
+/**
+ * Stop the input thread and close all devices.
+ */
+void stream_evdev_stop(stream_evdev_t *evdev);
+
+/**
+ * Whether input should be sent to host. Can be called from any thread.
+ */
+void stream_evdev_set_forwarding(stream_evdev_t *evdev, bool forwarding);
+
+/**
+ * Whether every keyboard connected is read here. Can be called from any thread.
+ */
+bool stream_evdev_reads_all_keyboards(stream_evdev_t *evdev);
+
+/**
+ * Whether every mouse connected is read here. Always false without relmouse. Can be called from any thread.
+ */
+bool stream_evdev_reads_all_mice(stream_evdev_t *evdev);
@@ -1,5 +1,4 @@
 #include "app.h"
-#include "ui/app_ui.h"
 
 #include "stream_input.h"
 #include "stream_manager_internal.h"
@@ -30,11 +29,21 @@ bool stream_input_handle_key_event(stream_manager_t *manager, const SDL_Keyboard
     if (!manager->app->settings->enable_input) {
         return true;
     }
+#if IHSPLAY_FEATURE_EVDEV_INPUT
+    if (manager->evdev != NULL && stream_evdev_reads_all_keyboards(manager->evdev)) {
+        // Already sent by evdev input thread
+        return true;
+    }
+#endif
+    stream_input_flush_mouse_motion(manager);
     if (event->state == SDL_PRESSED) {
         IHS_SessionSendKeyDown(manager->session, event->keysym.scancode);
     } else {
         IHS_SessionSendKeyUp(manager->session, event->keysym.scancode);
     }
+    if (manager->input_trace != NULL) {
+        input_trace_record_ticks(manager->input_trace, INPUT_TRACE_KEYBOARD, event->timestamp);
+    }
     return true;
 }
 
@@ -42,23 +51,36 @@ bool stream_input_handle_mouse_event(stream_manager_t *manager, const SDL_Event
     if (!manager->app->settings->enable_input) {
         return true;
     }
+#if IHSPLAY_FEATURE_EVDEV_INPUT
+    if (manager->evdev != NULL && stream_evdev_reads_all_mice(manager->evdev)) {
+        // Already sent by evdev input thread
+        return true;
+    }
+#endif
     switch (event->type) {
         case SDL_MOUSEMOTION: {
             if (input_manager_get_and_reset_mouse_movement(manager->app->input_manager)) {
                 break;
             }
+            // Sent by stream_input_flush_mouse_motion, after the event loop pass or before next button/wheel event
+            stream_input_mouse_motion_t *motion = &manager->mouse_motion;
+            motion->events++;
+            if (!motion->pending) {
+                motion->timestamp = event->motion.timestamp;
+            }
+            motion->pending = true;
             if (manager->app->settings->relmouse) {
-                IHS_SessionSendMouseMovement(manager->session, event->motion.xrel, event->motion.yrel);
+                motion->dx += event->motion.xrel;
+                motion->dy += event->motion.yrel;
             } else {
-                int w, h;
-                SDL_GetWindowSize(manager->app->ui->window, &w, &h);
-                IHS_SessionSendMousePosition(manager->session, (float) event->motion.x / (float) w,
-                                             (float) event->motion.y / (float) h);
+                stream_viewport_window_to_host(&manager->viewport, event->motion.x, event->motion.y, &motion->x,
+                                               &motion->y);
             }
             return true;
         }
         case SDL_MOUSEBUTTONDOWN:
         case SDL_MOUSEBUTTONUP: {
+            stream_input_flush_mouse_motion(manager);
             IHS_StreamInputMouseButton button = 0;
             switch (event->button.button) {
                 case SDL_BUTTON_LEFT:
@@ -83,10 +105,14 @@ bool stream_input_handle_mouse_event(stream_manager_t *manager, const SDL_Event
                 } else {
                     IHS_SessionSendMouseDown(manager->session, button);
                 }
+                if (manager->input_trace != NULL) {
+                    input_trace_record_ticks(manager->input_trace, INPUT_TRACE_MOUSE_BUTTON, event->button.timestamp);
+                }
             }
             return true;
         }
         case SDL_MOUSEWHEEL: {
+            stream_input_flush_mouse_motion(manager);
             Sint32 x = event->wheel.x, y = event->wheel.y;
             if (event->wheel.direction == SDL_MOUSEWHEEL_FLIPPED) {
                 x *= -1;
@@ -98,8 +124,33 @@ bool stream_input_handle_mouse_event(stream_manager_t *manager, const SDL_Event
             if (y != 0) {
                 IHS_SessionSendMouseWheel(manager->session, y > 0 ? IHS_MOUSE_WHEEL_UP : IHS_MOUSE_WHEEL_DOWN);
             }
+            if (manager->input_trace != NULL && (x != 0 || y != 0)) {
+                input_trace_record_ticks(manager->input_trace, INPUT_TRACE_MOUSE_WHEEL, event->wheel.timestamp);
+            }
             return true;
         }
     }
     return false;
-}
\ No newline at end of file
+}
+
+void stream_input_flush_mouse_motion(stream_manager_t *manager) {
+    stream_input_mouse_motion_t *motion = &manager->mouse_motion;
+    if (!motion->pending) {
+        return;
+    }
+    motion->pending = false;
+    if (manager->app->settings->relmouse) {
+        if (motion->dx == 0 && motion->dy == 0) {
+            return;
+        }
+        IHS_SessionSendMouseMovement(manager->session, motion->dx, motion->dy);
+        motion->dx = 0;
+        motion->dy = 0;
+    } else {
+        IHS_SessionSendMousePosition(manager->session, motion->x, motion->y);
+    }
+    motion->sent++;
+    if (manager->input_trace != NULL) {
+        input_trace_record_ticks(manager->input_trace, INPUT_TRACE_MOUSE_MOTION, motion->timestamp);
+    }
+}
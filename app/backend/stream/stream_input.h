@@ -2,6 +2,28 @@
 
 #include "stream_manager.h"
 
+/**
+ * Mouse motion of an event loop pass, sent to host as one message.
+ */
+typedef struct stream_input_mouse_motion_t {
+    bool pending;
+    /** Relative movement */
+    int dx, dy;
+    /** Latest absolute position, used when relative mouse is disabled */
+    float x, y;
+    /** SDL timestamp of the first motion event since last sent */
+    Uint32 timestamp;
+    /** Motion events received from SDL */
+    uint32_t events;
+    /** Motion messages sent to host */
+    uint32_t sent;
+} stream_input_mouse_motion_t;
+
 bool stream_input_handle_key_event(stream_manager_t *manager, const SDL_KeyboardEvent *event);
 
 bool stream_input_handle_mouse_event(stream_manager_t *manager, const SDL_Event *event);
+
+/**
+ * Send accumulated mouse motion, if any.
+ */
+void stream_input_flush_mouse_motion(stream_manager_t *manager);
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <string.h>
 #include "stream_manager.h"
 #include "stream_manager_internal.h"
 
@@ -36,6 +37,8 @@ static void session_disconnected_main(app_t *app, void *context);
 
 static void session_show_cursor_main(app_t *app, void *context);
 
+static void capture_size_changed_main(app_t *app, void *context);
+
 static void destroy_session_main(app_t *app, void *context);
 
 static void controller_back_pressed(stream_manager_t *manager);
@@ -50,8 +53,14 @@ static void back_timer_finish_main(app_t *app, void *context);
 
 static void grab_mouse(stream_manager_t *manager, bool grab);
 
+static void send_hid_event(const SDL_Event *event, void *context);
+
 #define BACK_COUNTER_MAX 100
 
+typedef struct cursor_position_t {
+    float x, y;
+} cursor_position_t;
+
 typedef struct event_context_t {
     stream_manager_t *manager;
     void *arg1;
@@ -78,6 +87,11 @@ stream_manager_t *stream_manager_create(app_t *app) {
     stream_manager_t *manager = calloc(1, sizeof(stream_manager_t));
     manager->app = app;
     manager->listeners = listeners_list_create();
+    manager->session_completion = completion_create();
+    hid_report_limiter_init(&manager->hid_limiter, app->settings->gamepad_report_rate, send_hid_event, manager);
+    if (app->settings->input_trace_path != NULL) {
+        manager->input_trace = input_trace_create();
+    }
     return manager;
 }
 
@@ -92,6 +106,10 @@ void stream_manager_destroy(stream_manager_t *manager) {
         }
     }
     listeners_list_destroy(manager->listeners);
+    completion_destroy(manager->session_completion);
+    if (manager->input_trace != NULL) {
+        input_trace_destroy(manager->input_trace);
+    }
     free(manager);
 }
 
@@ -128,9 +146,6 @@ bool stream_manager_start_session(stream_manager_t *manager, const IHS_SessionIn
     commons_log_info("StreamManager", "Change state to CONNECTING");
     manager->session = session;
 
-    stream_media_set_viewport_size(media, manager->viewport_width, manager->viewport_height);
-    stream_media_set_overlay_height(media, manager->overlay_height);
-
     IHS_SessionConnect(session);
     return true;
 }
@@ -212,16 +227,31 @@ void stream_manager_handle_event(stream_manager_t *manager, const SDL_Event *eve
         }
     }
     if (manager->app->settings->enable_input) {
-        IHS_HIDHandleSDLEvent(manager->session, event);
+        switch (event->type) {
+            case SDL_CONTROLLERAXISMOTION:
+            case SDL_CONTROLLERBUTTONDOWN:
+            case SDL_CONTROLLERBUTTONUP:
+            case SDL_CONTROLLERDEVICEREMOVED:
+                hid_report_limiter_handle_event(&manager->hid_limiter, event, SDL_GetTicks());
+                break;
+            default:
+                IHS_HIDHandleSDLEvent(manager->session, event);
+                break;
+        }
+    }
+}
+
+Uint32 stream_manager_flush_input(stream_manager_t *manager) {
+    if (manager->state != STREAM_MANAGER_STATE_STREAMING) {
+        return UINT32_MAX;
     }
+    stream_input_flush_mouse_motion(manager);
+    return hid_report_limiter_flush(&manager->hid_limiter, SDL_GetTicks());
 }
 
 void stream_manager_set_viewport_size(stream_manager_t *manager, int width, int height) {
     manager->viewport_width = width;
     manager->viewport_height = height;
-    if (manager->media != NULL) {
-        stream_media_set_viewport_size(manager->media, width, height);
-    }
 }
 
 bool stream_manager_is_overlay_opened(const stream_manager_t *manager) {
@@ -233,9 +263,6 @@ bool stream_manager_is_overlay_opened(const stream_manager_t *manager) {
 
 void stream_manager_set_overlay_height(stream_manager_t *manager, int height) {
     manager->overlay_height = height;
-    if (manager->media != NULL) {
-        stream_media_set_overlay_height(manager->media, height);
-    }
 }
 
 bool stream_manager_set_overlay_opened(stream_manager_t *manager, bool opened) {
@@ -244,7 +271,18 @@ bool stream_manager_set_overlay_opened(stream_manager_t *manager, bool opened) {
         return false;
     }
     manager->overlay_opened = opened;
-    stream_media_set_overlay_shown(manager->media, opened);
+    SDL_Rect area;
+    if (opened && stream_viewport_overlay_video_area(&manager->viewport, manager->viewport_height,
+                                                     manager->overlay_height, &area)) {
+        stream_media_set_overlay_shown(manager->media, &area, manager->viewport.window_height);
+    } else {
+        stream_media_set_overlay_shown(manager->media, NULL, 0);
+    }
+#if IHSPLAY_FEATURE_EVDEV_INPUT
+    if (manager->evdev != NULL) {
+        stream_evdev_set_forwarding(manager->evdev, !opened);
+    }
+#endif
     if (opened) {
         app_post_event(manager->app, APP_UI_REQUEST_OVERLAY, NULL, NULL);
     } else {
@@ -254,15 +292,28 @@ bool stream_manager_set_overlay_opened(stream_manager_t *manager, bool opened) {
     return true;
 }
 
+void stream_manager_set_window_size(stream_manager_t *manager, int width, int height) {
+    app_assert_main_thread(manager->app);
+    stream_viewport_set_window_size(&manager->viewport, width, height);
+}
+
 void stream_manager_set_capture_size(stream_manager_t *manager, int width, int height) {
-    manager->capture_width = width;
-    manager->capture_height = height;
+    SDL_Point *size = calloc(1, sizeof(SDL_Point));
+    size->x = width;
+    size->y = height;
+    if (app_run_on_main(manager->app, capture_size_changed_main, size) != 0) {
+        free(size);
+    }
 }
 
 bool stream_manager_is_active(const stream_manager_t *manager) {
     return manager->state == STREAM_MANAGER_STATE_STREAMING;
 }
 
+const input_trace_t *stream_manager_get_input_trace(const stream_manager_t *manager) {
+    return manager->input_trace;
+}
+
 static void session_initialized(IHS_Session *session, void *context) {
     stream_manager_t *manager = (stream_manager_t *) context;
     assert (manager->state == STREAM_MANAGER_STATE_CONNECTING);
@@ -295,7 +346,7 @@ static void session_connected(IHS_Session *session, void *context) {
             .manager = manager,
             .arg1 = (void *) IHS_SessionGetInfo(session),
     };
-    app_run_on_main_sync(manager->app, session_connected_main, &ec);
+    app_run_on_main_sync_with(manager->app, manager->session_completion, session_connected_main, &ec);
     if (manager->app->settings->enable_input) {
         IHS_SessionHIDNotifyDeviceChange(session);
     }
@@ -317,40 +368,67 @@ static void session_disconnected(IHS_Session *session, void *context) {
             .arg1 = (void *) IHS_SessionGetInfo(session),
             .value1 = requested
     };
-    app_run_on_main_sync(manager->app, session_disconnected_main, &ec);
+    app_run_on_main_sync_with(manager->app, manager->session_completion, session_disconnected_main, &ec);
 }
 
 static void session_show_cursor(IHS_Session *session, float x, float y, void *context) {
     (void) session;
     stream_manager_t *manager = (stream_manager_t *) context;
-    if (manager->capture_width <= 0 && manager->capture_height <= 0 || manager->viewport_width <= 0 ||
-        manager->viewport_height <= 0) {
-        return;
-    }
     if (stream_manager_is_overlay_opened(manager)) {
         return;
     }
-    float scale = SDL_min((float) manager->viewport_width / manager->capture_width,
-                          (float) manager->viewport_height / manager->capture_height);
-    float dst_width = (float) manager->capture_width * scale, dst_height = (float) manager->capture_height * scale;
-    SDL_Point *point = calloc(1, sizeof(SDL_Point));
-    point->x = (int) (((float) manager->viewport_width - dst_width) / 2.0f + dst_width * x);
-    point->y = (int) (((float) manager->viewport_height - dst_height) / 2.0f + dst_height * y);
-    app_run_on_main(manager->app, session_show_cursor_main, point);
+    // Viewport is owned by main thread, map the position there
+    cursor_position_t *position = calloc(1, sizeof(cursor_position_t));
+    position->x = x;
+    position->y = y;
+    if (app_run_on_main(manager->app, session_show_cursor_main, position) != 0) {
+        free(position);
+    }
 }
 
 static void session_connected_main(app_t *app, void *context) {
     (void) app;
     event_context_t *ec = context;
     stream_manager_t *manager = ec->manager;
+    memset(&manager->mouse_motion, 0, sizeof(stream_input_mouse_motion_t));
+    hid_report_limiter_reset(&manager->hid_limiter);
+    if (manager->input_trace != NULL) {
+        input_trace_reset(manager->input_trace);
+    }
     listeners_list_notify(manager->listeners, stream_manager_listener_t, connected, (const IHS_SessionInfo *) ec->arg1);
     grab_mouse(manager, true);
+#if IHSPLAY_FEATURE_EVDEV_INPUT
+    const app_settings_t *settings = manager->app->settings;
+    if (settings->enable_input && settings->evdev_input) {
+        manager->evdev = stream_evdev_start(manager->session, settings->relmouse, manager->input_trace);
+    }
+#endif
 }
 
 static void session_disconnected_main(app_t *app, void *context) {
     (void) app;
     event_context_t *ec = context;
     stream_manager_t *manager = ec->manager;
+    commons_log_info("StreamManager", "Mouse motion: %u events sent as %u messages", manager->mouse_motion.events,
+                     manager->mouse_motion.sent);
+    manager->mouse_motion.pending = false;
+    commons_log_info("StreamManager", "Gamepad axis: %u events sent as %u reports", manager->hid_limiter.received,
+                     manager->hid_limiter.sent);
+    hid_report_limiter_reset(&manager->hid_limiter);
+#if IHSPLAY_FEATURE_EVDEV_INPUT
+    if (manager->evdev != NULL) {
+        stream_evdev_stop(manager->evdev);
+        manager->evdev = NULL;
+    }
+#endif
+    if (manager->input_trace != NULL) {
+        const char *path = manager->app->settings->input_trace_path;
+        if (input_trace_dump(manager->input_trace, path, "Session input latency")) {
+            commons_log_info("StreamManager", "Input latency written to %s", path);
+        } else {
+            commons_log_warn("StreamManager", "Can't write input latency to %s", path);
+        }
+    }
     grab_mouse(manager, false);
     listeners_list_notify(manager->listeners, stream_manager_listener_t, disconnected,
                           (const IHS_SessionInfo *) ec->arg1, ec->value1);
@@ -358,9 +436,18 @@ static void session_disconnected_main(app_t *app, void *context) {
 
 static void session_show_cursor_main(app_t *app, void *context) {
     stream_manager_t *manager = app->stream_manager;
-    SDL_Point *point = context;
-    input_manager_ignore_next_mouse_movement(manager->app->input_manager);
-//    SDL_WarpMouseInWindow(app->ui->window, point->x, point->y);
+    cursor_position_t *position = context;
+    SDL_Point point;
+    if (stream_viewport_host_to_window(&manager->viewport, position->x, position->y, &point)) {
+        input_manager_ignore_next_mouse_movement(manager->app->input_manager);
+//        SDL_WarpMouseInWindow(app->ui->window, point.x, point.y);
+    }
+    free(context);
+}
+
+static void capture_size_changed_main(app_t *app, void *context) {
+    SDL_Point *size = context;
+    stream_viewport_set_capture_size(&app->stream_manager->viewport, size->x, size->y);
     free(context);
 }
 
@@ -402,6 +489,14 @@ static void grab_mouse(stream_manager_t *manager, bool grab) {
 }
 
 
+static void send_hid_event(const SDL_Event *event, void *context) {
+    stream_manager_t *manager = context;
+    IHS_HIDHandleSDLEvent(manager->session, event);
+    if (manager->input_trace != NULL && event->type != SDL_CONTROLLERDEVICEREMOVED) {
+        input_trace_record_ticks(manager->input_trace, INPUT_TRACE_GAMEPAD, event->common.timestamp);
+    }
+}
+
 static Uint32 back_timer_callback(Uint32 duration, void *param) {
     (void) duration;
     stream_manager_t *manager = (stream_manager_t *) param;
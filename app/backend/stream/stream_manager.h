@@ -6,6 +6,7 @@
 
 typedef struct app_t app_t;
 typedef struct host_manager_t host_manager_t;
+typedef struct input_trace_t input_trace_t;
 
 typedef struct stream_manager_t stream_manager_t;
 
@@ -42,6 +43,12 @@ bool stream_manager_intercept_event(const stream_manager_t *manager, const SDL_E
 
 void stream_manager_handle_event(stream_manager_t *manager, const SDL_Event *event);
 
+/**
+ * Send input coalesced from events handled so far. Called after each event loop pass.
+ * @return Milliseconds until input should be flushed again, or UINT32_MAX if nothing is pending
+ */
+Uint32 stream_manager_flush_input(stream_manager_t *manager);
+
 void stream_manager_set_viewport_size(stream_manager_t *manager, int width, int height);
 
 bool stream_manager_is_overlay_opened(const stream_manager_t *manager);
@@ -50,6 +57,19 @@ void stream_manager_set_overlay_height(stream_manager_t *manager, int height);
 
 bool stream_manager_set_overlay_opened(stream_manager_t *manager, bool opened);
 
+/**
+ * Update window size used for mapping pointer positions. Main thread only.
+ */
+void stream_manager_set_window_size(stream_manager_t *manager, int width, int height);
+
+/**
+ * Can be called from any thread. Viewport will be updated on main thread.
+ */
 void stream_manager_set_capture_size(stream_manager_t *manager, int width, int height);
 
-bool stream_manager_is_active(const stream_manager_t *manager);
\ No newline at end of file
+bool stream_manager_is_active(const stream_manager_t *manager);
+
+/**
+ * @return Input latency histograms of current session, or NULL if input tracing is disabled
+ */
+const input_trace_t *stream_manager_get_input_trace(const stream_manager_t *manager);
\ No newline at end of file
@@ -1,9 +1,19 @@
 #pragma once
 
+#include "config.h"
 #include "stream_manager.h"
 #include "stream_media.h"
+#include "stream_input.h"
+#include "stream_viewport.h"
+#include "input_trace.h"
+#include "hid_report_limiter.h"
+#if IHSPLAY_FEATURE_EVDEV_INPUT
+#include "stream_evdev.h"
+#endif
 
 #include "array_list.h"
+#include "util/display_mode.h"
+#include "util/completion.h"
 
 typedef enum stream_manager_state_t {
     STREAM_MANAGER_STATE_IDLE,
@@ -24,8 +34,25 @@ struct stream_manager_t {
     int back_counter;
     bool overlay_opened;
     bool requested_disconnect;
+    /** Session callbacks run on ihslib threads, which don't free thread-local completions, so they wait on this */
+    completion_t *session_completion;
 
+    /** Size of UI, which is scaled to window and can be smaller than it */
     int viewport_width, viewport_height;
-    int capture_width, capture_height;
+    /** In UI pixels */
     int overlay_height;
+    /** Main thread only */
+    stream_viewport_t viewport;
+    /** Main thread only */
+    display_mode_state_t display_mode;
+    /** Main thread only */
+    stream_input_mouse_motion_t mouse_motion;
+    /** NULL if input tracing is disabled */
+    input_trace_t *input_trace;
+    /** Main thread only */
+    hid_report_limiter_t hid_limiter;
+#if IHSPLAY_FEATURE_EVDEV_INPUT
+    /** Main thread only. Sends keyboard and mouse input from its own thread, NULL if not running */
+    stream_evdev_t *evdev;
+#endif
 };
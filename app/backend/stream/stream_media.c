@@ -1,15 +1,66 @@
 #include <stdlib.h>
+#include <string.h>
 #include "stream_media.h"
 
 #include "ss4s.h"
 #include "stream_manager.h"
+#include "stream_manager_internal.h"
+#include "packet_queue.h"
+#include "audio_jitter.h"
+#include "audio_resampler.h"
 #include "app.h"
+#include "config.h"
 #include "logging.h"
 #include "util/video/sps/include/sps_util.h"
 
 #include <opus_multistream.h>
 #include <SDL2/SDL.h>
 
+#define SPS_CACHE_MAX_SIZE 512
+/** Number of frames to measure frame rate from, when SPS doesn't have timing info */
+#define CADENCE_WINDOW_FRAMES 240
+/** Gaps longer than this many frames are treated as a stall, and won't be concealed */
+#define AUDIO_MAX_CONCEALED_FRAMES 20
+/** Number of compressed audio packets can be queued for the audio thread */
+#define AUDIO_QUEUE_DEPTH 32
+/** Longest frame an Opus packet can hold */
+#define OPUS_MAX_FRAME_MS 120
+
+/**
+ * Opus multistream layout for a channel count. Streams are laid out as the surround encoder does (Vorbis channel
+ * order), and the mapping reorders decoded channels to WAVE order (FL, FR, FC, LFE, BL, BR, SL, SR) for audio sinks.
+ */
+typedef struct audio_stream_layout_t {
+    int channels;
+    int streams;
+    int coupled_streams;
+    unsigned char mapping[AUDIO_RESAMPLER_MAX_CHANNELS];
+} audio_stream_layout_t;
+
+static const audio_stream_layout_t audio_stream_layouts[] = {
+        {1, 1, 0, {0}},
+        {2, 1, 1, {0, 1}},
+        {6, 4, 2, {0, 1, 4, 5, 2, 3}},
+        {8, 5, 3, {0, 1, 6, 7, 4, 5, 2, 3}},
+};
+
+/** Why the video feeder is dropping frames until next keyframe */
+typedef enum video_drop_reason_t {
+    VIDEO_DROP_NONE = 0,
+    /** Queued frames exceeded latency bounds */
+    VIDEO_DROP_BEHIND,
+    /** Decoder rejected a frame */
+    VIDEO_DROP_FEED_ERROR,
+} video_drop_reason_t;
+
+typedef struct video_sps_cache_t {
+    uint32_t hash;
+    size_t size;
+    unsigned char data[SPS_CACHE_MAX_SIZE];
+    bool parsed;
+    sps_info_t info;
+} video_sps_cache_t;
+
 struct stream_media_session_t {
     stream_manager_t *manager;
     SDL_mutex *lock;
@@ -17,13 +68,63 @@ struct stream_media_session_t {
     SS4S_VideoCapabilities video_cap;
 
     SS4S_VideoInfo video_info;
+    packet_queue_t *video_queue;
+    SDL_Thread *video_feeder;
+    SDL_atomic_t video_feeding;
+    /** Network thread only. After a frame got dropped, following frames are useless until next keyframe */
+    bool video_wait_keyframe;
+    uint32_t video_skipped;
+    /** Feeder thread only. Frames dropped while waiting for a keyframe */
+    uint32_t video_dropped;
+    /** Feeder thread only. Keyframes fed after dropping frames because decoder fell behind */
+    uint32_t video_recovered_keyframes;
+    /** Feeder thread only. Keyframes fed after dropping frames because decoder rejected one */
+    uint32_t video_error_recovered_keyframes;
+    /** Feeder thread only. Frames the decoder didn't accept */
+    uint32_t video_feed_errors;
+    /** Set by feeder thread when it drops frames until next keyframe, consumed by video_submit to report to ihslib */
+    SDL_atomic_t video_keyframe_requested;
+    /** Feeder thread only. Last seen SPS, so unchanged SPS won't be parsed again */
+    video_sps_cache_t sps_cache;
+    /** Feeder thread only. NAL units of the frame being fed */
+    sps_nal_index_t video_nal_index;
+    /** Network thread only. Arrival time of first frame in the cadence window */
+    Uint32 video_cadence_begin;
+    uint32_t video_cadence_frames;
+    /** Frame rate requested for display mode matching, in mHz. 0 if not requested yet */
+    SDL_atomic_t video_frame_rate_mhz;
+    /** Frame rate is known from SPS timing info, so measured cadence won't be used */
+    SDL_atomic_t video_frame_rate_from_sps;
+
+    packet_queue_t *audio_queue;
+    SDL_Thread *audio_worker;
+    SDL_atomic_t audio_decoding;
+    /** Below are audio thread only */
     OpusMSDecoder *opus_decoder;
+    /** Decode to float samples, because audio sink takes them natively */
+    bool pcm_float;
     size_t pcm_unit_size;
-    int16_t *pcm_buffer;
-
+    /** Below PCM buffers hold int16_t or float samples, depending on pcm_float */
+    void *pcm_buffer;
+    /** Zeroes to fill up sink backlog */
+    void *pcm_silence;
+    /** Output of audio_resampler, one sample larger than pcm_buffer */
+    void *pcm_resampled;
+
+    /** Capacity of PCM buffers in samples per channel, enough for longest Opus frame */
     int pcm_buffer_size;
-    int viewport_width, viewport_height;
-    int overlay_height;
+    int audio_sample_rate;
+    /** Samples per channel of last decoded packet */
+    int audio_frame_samples;
+    /** Frames synthesized by packet loss concealment */
+    uint32_t audio_concealed_frames;
+    /** Gaps too long to be concealed */
+    uint32_t audio_stalls;
+    audio_jitter_t audio_jitter;
+    /** Samples decoded since last packet arrival, including concealed ones */
+    int audio_jitter_samples;
+    /** Compensates clock drift between host and sink */
+    audio_resampler_t audio_resampler;
 };
 
 static int audio_start(IHS_Session *session, const IHS_StreamAudioConfig *config, void *context);
@@ -32,6 +133,34 @@ static void audio_stop(IHS_Session *session, void *context);
 
 static int audio_submit(IHS_Session *session, IHS_Buffer *data, void *context);
 
+static int audio_worker(void *context);
+
+static void audio_free_decoder(stream_media_session_t *media_session);
+
+static int audio_decode_packet(stream_media_session_t *media_session, const unsigned char *packet, size_t size,
+                               Uint64 arrival_us);
+
+static int audio_decode(stream_media_session_t *media_session, const unsigned char *packet, size_t size,
+                        int frame_size);
+
+static bool audio_sink_supports_float();
+
+static const audio_stream_layout_t *audio_find_stream_layout(uint32_t channels);
+
+static int audio_detect_gap(stream_media_session_t *media_session, Uint64 now_us, int64_t pending_us);
+
+static void audio_conceal_gap(stream_media_session_t *media_session, int lost_frames);
+
+static int audio_feed_pcm(stream_media_session_t *media_session, int samples);
+
+static int64_t audio_samples_us(const stream_media_session_t *media_session, int samples);
+
+static void audio_feed_silence(stream_media_session_t *media_session, int samples);
+
+static Uint64 audio_now_us();
+
+static Uint64 audio_counter_us(Uint64 counter);
+
 static int video_start(IHS_Session *session, const IHS_StreamVideoConfig *config, void *context);
 
 static void video_stop(IHS_Session *session, void *context);
@@ -40,6 +169,30 @@ static int video_submit(IHS_Session *session, IHS_Buffer *data, IHS_StreamVideoF
 
 static int video_set_capture_size(IHS_Session *session, int width, int height, void *context);
 
+static int video_feeder_worker(void *context);
+
+static bool video_feeder_behind(const stream_media_session_t *media_session, const packet_queue_slot_t *slot);
+
+static SS4S_VideoFeedResult video_feed_frame(stream_media_session_t *media_session, const unsigned char *data,
+                                             size_t size, uint32_t flags);
+
+static bool video_feed_failed(stream_media_session_t *media_session, SS4S_VideoFeedResult result);
+
+static void video_index_nal_units(stream_media_session_t *media_session, const unsigned char *data, size_t size);
+
+static bool video_parse_sps(stream_media_session_t *media_session, const unsigned char *data, size_t size,
+                            sps_info_t *info);
+
+static uint32_t sps_hash(const unsigned char *data, size_t size);
+
+static void video_measure_cadence(stream_media_session_t *media_session);
+
+static void video_request_frame_rate(stream_media_session_t *media_session, double frame_rate, const char *source);
+
+static void video_match_display_mode(app_t *app, void *data);
+
+static void video_restore_display_mode(app_t *app, void *data);
+
 static const IHS_StreamAudioCallbacks audio_callbacks = {
         .start = audio_start,
         .stop = audio_stop,
@@ -70,39 +223,21 @@ void stream_media_destroy(stream_media_session_t *media_session) {
     free(media_session);
 }
 
-void stream_media_set_viewport_size(stream_media_session_t *media_session, int width, int height) {
-    SDL_LockMutex(media_session->lock);
-    media_session->viewport_width = width;
-    media_session->viewport_height = height;
-    SDL_UnlockMutex(media_session->lock);
-}
-
-void stream_media_set_overlay_height(stream_media_session_t *media_session, int height) {
-    SDL_LockMutex(media_session->lock);
-    media_session->overlay_height = height;
-    SDL_UnlockMutex(media_session->lock);
-}
-
-void stream_media_set_overlay_shown(stream_media_session_t *media_session, bool overlay) {
+void stream_media_set_overlay_shown(stream_media_session_t *media_session, const SDL_Rect *area, int window_height) {
     if (media_session->video_cap.transform & SS4S_VIDEO_CAP_TRANSFORM_UI_COMPOSITING) {
         return;
     }
-    if (overlay) {
+    if (area != NULL && window_height > 0) {
+        // Crop video to the part of screen the area covers, so it keeps the scale it had without overlay
         SDL_LockMutex(media_session->lock);
-        int ui_width = media_session->viewport_width, ui_height = media_session->viewport_height,
-                overlay_height = media_session->overlay_height;
-        if (ui_width <= 0 || ui_height <= 0 || overlay_height <= 0) {
-            SDL_UnlockMutex(media_session->lock);
-            return;
-        }
         SS4S_VideoRect src = {
                 .x = 0, .y = 0,
                 .width = media_session->video_info.width,
-                .height = media_session->video_info.height * (ui_height - overlay_height) / ui_height
+                .height = media_session->video_info.height * area->h / window_height
         };
         SDL_UnlockMutex(media_session->lock);
 
-        SS4S_VideoRect dest = {0, 0, ui_width, ui_height - overlay_height};
+        SS4S_VideoRect dest = {area->x, area->y, area->w, area->h};
         SS4S_PlayerVideoSetDisplayArea(media_session->player, &src, &dest);
     } else {
         SS4S_PlayerVideoSetDisplayArea(media_session->player, NULL, NULL);
@@ -128,19 +263,52 @@ static int audio_start(IHS_Session *session, const IHS_StreamAudioConfig *config
     if (config->codec != IHS_StreamAudioCodecOpus) {
         return -1;
     }
+    const audio_stream_layout_t *layout = audio_find_stream_layout(config->channels);
+    if (layout == NULL) {
+        commons_log_error("Media", "Unsupported audio channel count %u", config->channels);
+        return -1;
+    }
     stream_media_session_t *media_session = (stream_media_session_t *) context;
     SDL_LockMutex(media_session->lock);
     int rc;
-    unsigned char mapping[2] = {0, 1};
     const int samples_per_frame = 240;
-    media_session->pcm_buffer_size = samples_per_frame * 64;
-    media_session->pcm_unit_size = config->channels * sizeof(int16_t);
-
-    media_session->opus_decoder = opus_multistream_decoder_create(config->frequency, config->channels,
-                                                                  1, 1, mapping, &rc);
+    media_session->pcm_float = audio_sink_supports_float();
+    media_session->pcm_buffer_size = (int) config->frequency * OPUS_MAX_FRAME_MS / 1000;
+    media_session->pcm_unit_size = config->channels * (media_session->pcm_float ? sizeof(float) : sizeof(int16_t));
+
+    media_session->opus_decoder = opus_multistream_decoder_create(config->frequency, layout->channels,
+                                                                  layout->streams, layout->coupled_streams,
+                                                                  layout->mapping, &rc);
+    if (media_session->opus_decoder == NULL) {
+        commons_log_error("Media", "Failed to create Opus decoder: %s", opus_strerror(rc));
+        SDL_UnlockMutex(media_session->lock);
+        return -1;
+    }
     media_session->pcm_buffer = calloc(media_session->pcm_unit_size, media_session->pcm_buffer_size);
+    media_session->pcm_silence = calloc(media_session->pcm_unit_size, media_session->pcm_buffer_size);
+    media_session->pcm_resampled = calloc(media_session->pcm_unit_size, media_session->pcm_buffer_size + 1);
+    if (media_session->pcm_buffer == NULL || media_session->pcm_silence == NULL ||
+        media_session->pcm_resampled == NULL) {
+        commons_log_error("Media", "Failed to allocate audio buffers");
+        audio_free_decoder(media_session);
+        SDL_UnlockMutex(media_session->lock);
+        return -1;
+    }
+    media_session->audio_sample_rate = (int) config->frequency;
+    media_session->audio_frame_samples = 0;
+    media_session->audio_concealed_frames = 0;
+    media_session->audio_stalls = 0;
+    const app_settings_t *settings = media_session->manager->app->settings;
+    audio_jitter_init(&media_session->audio_jitter, (int) config->frequency, settings->audio_min_latency_ms,
+                      settings->audio_max_latency_ms);
+    media_session->audio_jitter_samples = 0;
+    audio_resampler_init(&media_session->audio_resampler, (int) config->channels, media_session->pcm_float);
     SS4S_AudioInfo info = {
+#if IHSPLAY_FEATURE_FLOAT_PCM
+            .codec = media_session->pcm_float ? SS4S_AUDIO_PCM_F32LE : SS4S_AUDIO_PCM_S16LE,
+#else
             .codec = SS4S_AUDIO_PCM_S16LE,
+#endif
             .numOfChannels = (int) config->channels,
             .sampleRate = (int) config->frequency,
             .samplesPerFrame = samples_per_frame,
@@ -148,24 +316,256 @@ static int audio_start(IHS_Session *session, const IHS_StreamAudioConfig *config
             .streamName = "Streaming",
     };
     SDL_UnlockMutex(media_session->lock);
-    return SS4S_PlayerAudioOpen(media_session->player, &info);
+    int ret = SS4S_PlayerAudioOpen(media_session->player, &info);
+    if (ret != 0) {
+        commons_log_error("Media", "Failed to open audio player (%d)", ret);
+        audio_free_decoder(media_session);
+        return ret;
+    }
+    packet_queue_t *queue = packet_queue_create(AUDIO_QUEUE_DEPTH);
+    if (queue == NULL) {
+        commons_log_error("Media", "Failed to create audio queue");
+        SS4S_PlayerAudioClose(media_session->player);
+        audio_free_decoder(media_session);
+        return -1;
+    }
+    media_session->audio_queue = queue;
+    SDL_AtomicSet(&media_session->audio_decoding, 1);
+    media_session->audio_worker = SDL_CreateThread(audio_worker, "audio_worker", media_session);
+    if (media_session->audio_worker == NULL) {
+        commons_log_error("Media", "Failed to start audio thread: %s", SDL_GetError());
+        SDL_AtomicSet(&media_session->audio_decoding, 0);
+        media_session->audio_queue = NULL;
+        packet_queue_destroy(queue);
+        SS4S_PlayerAudioClose(media_session->player);
+        audio_free_decoder(media_session);
+        return -1;
+    }
+    return 0;
 }
 
 static void audio_stop(IHS_Session *session, void *context) {
     (void) session;
     stream_media_session_t *media_session = (stream_media_session_t *) context;
+    if (media_session->audio_worker != NULL) {
+        SDL_AtomicSet(&media_session->audio_decoding, 0);
+        packet_queue_interrupt(media_session->audio_queue);
+        SDL_WaitThread(media_session->audio_worker, NULL);
+        media_session->audio_worker = NULL;
+
+        packet_queue_stats_t stats;
+        packet_queue_get_stats(media_session->audio_queue, &stats);
+        commons_log_info("Media", "Audio queue stats: pushed=%u, overflows=%u, high_water=%u", stats.pushed,
+                         stats.overflows, stats.high_water);
+        packet_queue_destroy(media_session->audio_queue);
+        media_session->audio_queue = NULL;
+    }
+    commons_log_info("Media", "Audio stats: concealed=%u, stalls=%u", media_session->audio_concealed_frames,
+                     media_session->audio_stalls);
+    const audio_jitter_t *jitter = &media_session->audio_jitter;
+    commons_log_info("Media", "Audio jitter stats: jitter=%dus, target=%dms, underruns=%u, dropped=%u, compressed=%u",
+                     (int) jitter->jitter_us, (int) (jitter->target_us / 1000), jitter->underruns,
+                     jitter->dropped_frames, jitter->compressed_frames);
+    commons_log_info("Media", "Audio drift correction: %dppm", media_session->audio_resampler.ppm);
     SS4S_PlayerAudioClose(media_session->player);
-    opus_multistream_decoder_destroy(media_session->opus_decoder);
-    free(media_session->pcm_buffer);
+    audio_free_decoder(media_session);
 }
 
 static int audio_submit(IHS_Session *session, IHS_Buffer *data, void *context) {
     (void) session;
     stream_media_session_t *media_session = (stream_media_session_t *) context;
-    int decode_len = opus_multistream_decode(media_session->opus_decoder, data->data + data->offset, data->size,
-                                             media_session->pcm_buffer, media_session->pcm_buffer_size, 0);
-    return SS4S_PlayerAudioFeed(media_session->player, (const unsigned char *) media_session->pcm_buffer,
-                                media_session->pcm_unit_size * decode_len);
+    if (media_session->audio_queue == NULL) {
+        return -1;
+    }
+    // Overflowed packets will be concealed as lost ones
+    packet_queue_push(media_session->audio_queue, IHS_BufferPointer(data), data->size, 0, 0);
+    return 0;
+}
+
+static void audio_free_decoder(stream_media_session_t *media_session) {
+    opus_multistream_decoder_destroy(media_session->opus_decoder);
+    media_session->opus_decoder = NULL;
+    free(media_session->pcm_buffer);
+    media_session->pcm_buffer = NULL;
+    free(media_session->pcm_silence);
+    media_session->pcm_silence = NULL;
+    free(media_session->pcm_resampled);
+    media_session->pcm_resampled = NULL;
+}
+
+static int audio_worker(void *context) {
+    stream_media_session_t *media_session = (stream_media_session_t *) context;
+    packet_queue_t *queue = media_session->audio_queue;
+    if (media_session->manager->app->settings->audio_realtime_priority &&
+        SDL_SetThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL) != 0) {
+        commons_log_warn("Media", "Can't set audio thread priority: %s", SDL_GetError());
+    }
+    while (SDL_AtomicGet(&media_session->audio_decoding)) {
+        packet_queue_slot_t *slot = packet_queue_peek(queue, SDL_MUTEX_MAXWAIT);
+        if (slot == NULL) {
+            continue;
+        }
+        audio_decode_packet(media_session, slot->data, slot->size, audio_counter_us(slot->counter));
+        packet_queue_pop(queue);
+    }
+    return 0;
+}
+
+/**
+ * @param arrival_us When the packet was received by network thread
+ */
+static int audio_decode_packet(stream_media_session_t *media_session, const unsigned char *packet, size_t size,
+                               Uint64 arrival_us) {
+    int64_t pending_us = audio_samples_us(media_session, media_session->audio_jitter_samples);
+    int lost_frames = audio_detect_gap(media_session, arrival_us, pending_us);
+    if (lost_frames > 0) {
+        audio_conceal_gap(media_session, lost_frames);
+    }
+    // Concealed frames count as arrived, so packet loss won't raise target latency
+    audio_jitter_arrived(&media_session->audio_jitter, arrival_us,
+                         audio_samples_us(media_session, media_session->audio_jitter_samples));
+    media_session->audio_jitter_samples = 0;
+    int decode_len = audio_decode(media_session, packet, size, media_session->pcm_buffer_size);
+    if (decode_len <= 0) {
+        return 0;
+    }
+    media_session->audio_frame_samples = decode_len;
+    return audio_feed_pcm(media_session, decode_len);
+}
+
+/**
+ * Decode into pcm_buffer, in the sample format negotiated with audio sink.
+ */
+static int audio_decode(stream_media_session_t *media_session, const unsigned char *packet, size_t size,
+                        int frame_size) {
+    if (media_session->pcm_float) {
+        return opus_multistream_decode_float(media_session->opus_decoder, packet, (opus_int32) size,
+                                             media_session->pcm_buffer, frame_size, 0);
+    }
+    return opus_multistream_decode(media_session->opus_decoder, packet, (opus_int32) size,
+                                   media_session->pcm_buffer, frame_size, 0);
+}
+
+static const audio_stream_layout_t *audio_find_stream_layout(uint32_t channels) {
+    for (size_t i = 0; i < sizeof(audio_stream_layouts) / sizeof(audio_stream_layout_t); i++) {
+        if (audio_stream_layouts[i].channels == (int) channels) {
+            return &audio_stream_layouts[i];
+        }
+    }
+    return NULL;
+}
+
+static bool audio_sink_supports_float() {
+#if IHSPLAY_FEATURE_FLOAT_PCM
+    SS4S_AudioCapabilities audio_cap;
+    if (SS4S_GetAudioCapabilities(&audio_cap) != 0) {
+        return false;
+    }
+    return (audio_cap.codecs & SS4S_AUDIO_PCM_F32LE) != 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * There's no sequence number for audio packets, so loss is detected by arrival time. Lateness is taken from the
+ * estimator in audio_jitter, and the part beyond usual jitter is counted as lost frames.
+ *
+ * @param pending_us Duration of samples fed since last packet arrival
+ * @return Number of frames lost before this packet
+ */
+static int audio_detect_gap(stream_media_session_t *media_session, Uint64 now_us, int64_t pending_us) {
+    if (media_session->audio_frame_samples <= 0) {
+        return 0;
+    }
+    const audio_jitter_t *jitter = &media_session->audio_jitter;
+    int64_t late = audio_jitter_lateness(jitter, now_us, pending_us);
+    int64_t frame_us = audio_samples_us(media_session, media_session->audio_frame_samples);
+    int64_t excess = late - 2 * jitter->jitter_us;
+    if (excess < frame_us / 2) {
+        return 0;
+    }
+    int64_t lost = (excess + frame_us / 2) / frame_us;
+    if (lost > AUDIO_MAX_CONCEALED_FRAMES) {
+        commons_log_debug("Media", "Audio stalled for %d ms", (int) (late / 1000));
+        media_session->audio_stalls++;
+        return 0;
+    }
+    return (int) lost;
+}
+
+/**
+ * Fill lost frames with PLC. In-band FEC of the packet after a gap carries the frame right before it, which is only
+ * lost if packets are missing. A gap found by timing may be a late packet whose previous frame already played, so
+ * FEC isn't used here.
+ */
+static void audio_conceal_gap(stream_media_session_t *media_session, int lost_frames) {
+    int frame_samples = media_session->audio_frame_samples;
+    for (int i = 0; i < lost_frames; i++) {
+        int decode_len = audio_decode(media_session, NULL, 0, frame_samples);
+        if (decode_len <= 0) {
+            return;
+        }
+        media_session->audio_concealed_frames++;
+        audio_feed_pcm(media_session, decode_len);
+    }
+}
+
+static int64_t audio_samples_us(const stream_media_session_t *media_session, int samples) {
+    return (int64_t) samples * 1000000 / media_session->audio_sample_rate;
+}
+
+static int audio_feed_pcm(stream_media_session_t *media_session, int samples) {
+    media_session->audio_jitter_samples += samples;
+    audio_jitter_t *jitter = &media_session->audio_jitter;
+    Uint64 now_us = audio_now_us();
+    if (jitter->playing) {
+        audio_resampler_update(&media_session->audio_resampler, now_us,
+                               audio_jitter_backlog_us(jitter, now_us) - jitter->target_us);
+    }
+    void *pcm = media_session->pcm_resampled;
+    samples = audio_resampler_process(&media_session->audio_resampler, media_session->pcm_buffer, samples, pcm);
+    int prefill_samples = 0;
+    switch (audio_jitter_check(jitter, now_us, samples, &prefill_samples)) {
+        case AUDIO_JITTER_DROP:
+            return SS4S_AUDIO_FEED_OK;
+        case AUDIO_JITTER_COMPRESS:
+            samples = audio_jitter_compress(pcm, media_session->audio_resampler.channels, samples,
+                                            media_session->pcm_float);
+            break;
+        default:
+            break;
+    }
+    if (prefill_samples > 0) {
+        audio_feed_silence(media_session, prefill_samples);
+    }
+    SS4S_AudioFeedResult result = SS4S_PlayerAudioFeed(media_session->player, (const unsigned char *) pcm,
+                                                       media_session->pcm_unit_size * samples);
+    audio_jitter_fed(jitter, samples, result == SS4S_AUDIO_FEED_OK);
+    return result;
+}
+
+static void audio_feed_silence(stream_media_session_t *media_session, int samples) {
+    while (samples > 0) {
+        int chunk = SDL_min(samples, media_session->pcm_buffer_size);
+        SS4S_AudioFeedResult result = SS4S_PlayerAudioFeed(media_session->player,
+                                                           (const unsigned char *) media_session->pcm_silence,
+                                                           media_session->pcm_unit_size * chunk);
+        audio_jitter_fed(&media_session->audio_jitter, chunk, result == SS4S_AUDIO_FEED_OK);
+        if (result != SS4S_AUDIO_FEED_OK) {
+            return;
+        }
+        samples -= chunk;
+    }
+}
+
+static Uint64 audio_now_us() {
+    return audio_counter_us(SDL_GetPerformanceCounter());
+}
+
+static Uint64 audio_counter_us(Uint64 counter) {
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
 }
 
 static int video_start(IHS_Session *session, const IHS_StreamVideoConfig *config, void *context) {
@@ -192,55 +592,319 @@ static int video_start(IHS_Session *session, const IHS_StreamVideoConfig *config
     };
     media_session->video_info = info;
     SDL_UnlockMutex(media_session->lock);
-    return SS4S_PlayerVideoOpen(media_session->player, &info);
+    int ret = SS4S_PlayerVideoOpen(media_session->player, &info);
+    if (ret != 0) {
+        commons_log_error("Media", "Failed to open video player (%d)", ret);
+        return ret;
+    }
+    const app_settings_t *settings = media_session->manager->app->settings;
+    packet_queue_t *queue = packet_queue_create(SDL_max(settings->video_queue_depth, 1));
+    if (queue == NULL) {
+        commons_log_error("Media", "Failed to create video queue");
+        SS4S_PlayerVideoClose(media_session->player);
+        return -1;
+    }
+    media_session->video_queue = queue;
+    media_session->video_wait_keyframe = false;
+    media_session->video_skipped = 0;
+    media_session->video_dropped = 0;
+    media_session->video_recovered_keyframes = 0;
+    media_session->video_error_recovered_keyframes = 0;
+    media_session->video_feed_errors = 0;
+    SDL_AtomicSet(&media_session->video_keyframe_requested, 0);
+    memset(&media_session->sps_cache, 0, sizeof(video_sps_cache_t));
+    media_session->video_cadence_frames = 0;
+    SDL_AtomicSet(&media_session->video_frame_rate_mhz, 0);
+    SDL_AtomicSet(&media_session->video_frame_rate_from_sps, 0);
+    SDL_AtomicSet(&media_session->video_feeding, 1);
+    media_session->video_feeder = SDL_CreateThread(video_feeder_worker, "video_feeder", media_session);
+    if (media_session->video_feeder == NULL) {
+        commons_log_error("Media", "Failed to start video thread: %s", SDL_GetError());
+        SDL_AtomicSet(&media_session->video_feeding, 0);
+        media_session->video_queue = NULL;
+        packet_queue_destroy(queue);
+        SS4S_PlayerVideoClose(media_session->player);
+        return -1;
+    }
+    return 0;
 }
 
 static void video_stop(IHS_Session *session, void *context) {
     (void) session;
     stream_media_session_t *media_session = (stream_media_session_t *) context;
+    if (media_session->video_feeder != NULL) {
+        SDL_AtomicSet(&media_session->video_feeding, 0);
+        packet_queue_interrupt(media_session->video_queue);
+        SDL_WaitThread(media_session->video_feeder, NULL);
+        media_session->video_feeder = NULL;
+
+        packet_queue_stats_t stats;
+        packet_queue_get_stats(media_session->video_queue, &stats);
+        commons_log_info("Media", "Video queue stats: pushed=%u, overflows=%u, high_water=%u, skipped=%u, "
+                                  "dropped=%u, recovered_keyframes=%u, feed_errors=%u, error_recovered_keyframes=%u",
+                         stats.pushed, stats.overflows, stats.high_water, media_session->video_skipped,
+                         media_session->video_dropped, media_session->video_recovered_keyframes,
+                         media_session->video_feed_errors, media_session->video_error_recovered_keyframes);
+        packet_queue_destroy(media_session->video_queue);
+        media_session->video_queue = NULL;
+    }
+    if (SDL_AtomicGet(&media_session->video_frame_rate_mhz) != 0) {
+        app_run_on_main(media_session->manager->app, video_restore_display_mode, NULL);
+    }
     SS4S_PlayerVideoClose(media_session->player);
 }
 
 static int video_submit(IHS_Session *session, IHS_Buffer *data, IHS_StreamVideoFrameFlag flags, void *context) {
     (void) session;
     stream_media_session_t *media_session = (stream_media_session_t *) context;
+    if (media_session->video_queue == NULL) {
+        return -1;
+    }
+    video_measure_cadence(media_session);
+    // Feeder dropped a frame, so frames until next keyframe are useless, and the host should send one
+    int ret = 0;
+    if (SDL_AtomicSet(&media_session->video_keyframe_requested, 0)) {
+        media_session->video_wait_keyframe = true;
+        ret = -1;
+    }
+    if (media_session->video_wait_keyframe) {
+        if (!(flags & IHS_StreamVideoFrameKeyFrame)) {
+            media_session->video_skipped++;
+            return ret;
+        }
+        media_session->video_wait_keyframe = false;
+    }
+    const app_settings_t *settings = media_session->manager->app->settings;
+    uint32_t timeout = 0;
+    if (settings->video_feed_policy == VIDEO_FEED_POLICY_WAIT) {
+        timeout = (uint32_t) SDL_max(settings->video_latency_bound_ms, 0);
+    }
+    if (!packet_queue_push(media_session->video_queue, IHS_BufferPointer(data), data->size, flags, timeout)) {
+        commons_log_warn("Media", "Video queue full, dropping frames until next keyframe");
+        media_session->video_wait_keyframe = true;
+        media_session->video_skipped++;
+        ret = -1;
+    }
+    return ret;
+}
+
+static SS4S_VideoFeedResult video_feed_frame(stream_media_session_t *media_session, const unsigned char *data,
+                                             size_t size, uint32_t flags) {
     SS4S_VideoFeedFlags sflgs = 0;
     if (flags & IHS_StreamVideoFrameKeyFrame) {
-        SDL_LockMutex(media_session->lock);
         sflgs = SS4S_VIDEO_FEED_DATA_KEYFRAME;
-        sps_dimension_t dimension = {0, 0};
-        bool dimension_parsed = false;
-        switch (media_session->video_info.codec) {
-            case SS4S_VIDEO_H264: {
-                dimension_parsed = sps_util_parse_dimension_h264(IHS_BufferPointer(data), data->size, &dimension);
-                break;
+        video_index_nal_units(media_session, data, size);
+        sps_info_t info;
+        // video_info is only modified by this thread while streaming, so it's safe to compare without lock
+        if (video_parse_sps(media_session, data, size, &info)) {
+            if (info.num_units_in_tick > 0 && info.time_scale > 0) {
+                // H.264 counts field ticks, so a frame takes two ticks
+                double ticks_per_frame = media_session->video_info.codec == SS4S_VIDEO_H264 ? 2 : 1;
+                SDL_AtomicSet(&media_session->video_frame_rate_from_sps, 1);
+                video_request_frame_rate(media_session,
+                                         info.time_scale / (info.num_units_in_tick * ticks_per_frame), "SPS");
             }
-            case SS4S_VIDEO_H265: {
-                dimension_parsed = sps_util_parse_dimension_hevc(IHS_BufferPointer(data), data->size, &dimension);
-                break;
-            }
-            default: {
-                commons_log_fatal("Media", "Unexpected video codec %s!!",
-                                  SS4S_VideoCodecName(media_session->video_info.codec));
-                abort();
+            sps_dimension_t dimension = info.dimension;
+            if (dimension.width != media_session->video_info.width ||
+                dimension.height != media_session->video_info.height) {
+                SDL_LockMutex(media_session->lock);
+                commons_log_info("Media", "Size change detected by NAL header. (%d*%d)=>(%d*%d)",
+                                 media_session->video_info.width, media_session->video_info.height, dimension.width,
+                                 dimension.height);
+                media_session->video_info.width = dimension.width;
+                media_session->video_info.height = dimension.height;
+                SDL_UnlockMutex(media_session->lock);
+                SS4S_PlayerVideoSizeChanged(media_session->player, dimension.width, dimension.height);
             }
         }
-        if (!dimension_parsed) {
-            commons_log_warn("Media", "Can't parse NAL Unit.");
-            commons_log_hexdump(COMMONS_LOG_LEVEL_WARN, "Media", IHS_BufferPointer(data), data->size);
+    }
+    return SS4S_PlayerVideoFeed(media_session->player, data, size, sflgs);
+}
+
+/**
+ * @return Whether following frames should be dropped until next keyframe
+ */
+static bool video_feed_failed(stream_media_session_t *media_session, SS4S_VideoFeedResult result) {
+    media_session->video_feed_errors++;
+    if (result == SS4S_VIDEO_FEED_NOT_READY) {
+        commons_log_debug("Media", "Decoder not ready, frame dropped");
+        return false;
+    }
+    commons_log_warn("Media", "Decoder rejected frame (%d), dropping frames until next keyframe", result);
+    SDL_AtomicSet(&media_session->video_keyframe_requested, 1);
+    return true;
+}
+
+static void video_index_nal_units(stream_media_session_t *media_session, const unsigned char *data, size_t size) {
+    SS4S_VideoCodec codec = media_session->video_info.codec;
+    switch (codec) {
+        case SS4S_VIDEO_H264: {
+            sps_util_nal_index_h264(data, size, &media_session->video_nal_index);
+            break;
         }
-        if (dimension_parsed && (dimension.width != media_session->video_info.width ||
-                                 dimension.height != media_session->video_info.height)) {
-            commons_log_info("Media", "Size change detected by NAL header. (%d*%d)=>(%d*%d)",
-                             media_session->video_info.width, media_session->video_info.height, dimension.width,
-                             dimension.height);
-            media_session->video_info.width = dimension.width;
-            media_session->video_info.height = dimension.height;
-            SS4S_PlayerVideoSizeChanged(media_session->player, dimension.width, dimension.height);
+        case SS4S_VIDEO_H265: {
+            sps_util_nal_index_hevc(data, size, &media_session->video_nal_index);
+            break;
         }
-        SDL_UnlockMutex(media_session->lock);
+        default: {
+            commons_log_fatal("Media", "Unexpected video codec %s!!", SS4S_VideoCodecName(codec));
+            abort();
+        }
+    }
+}
+
+/**
+ * Must be called after video_index_nal_units for the same frame
+ */
+static bool video_parse_sps(stream_media_session_t *media_session, const unsigned char *data, size_t size,
+                            sps_info_t *info) {
+    SS4S_VideoCodec codec = media_session->video_info.codec;
+    const sps_nal_unit_t *unit = sps_util_nal_index_find(&media_session->video_nal_index,
+                                                         codec == SS4S_VIDEO_H264 ? SPS_UTIL_NAL_TYPE_SPS_H264
+                                                                                  : SPS_UTIL_NAL_TYPE_SPS_HEVC);
+    if (unit == NULL) {
+        commons_log_warn("Media", "Can't find SPS in NAL Unit.");
+        commons_log_hexdump(COMMONS_LOG_LEVEL_WARN, "Media", data, size);
+        return false;
+    }
+    const unsigned char *sps = data + unit->offset;
+    size_t sps_size = unit->size;
+    video_sps_cache_t *cache = &media_session->sps_cache;
+    uint32_t hash = sps_hash(sps, sps_size);
+    if (cache->size == sps_size && cache->hash == hash && memcmp(cache->data, sps, sps_size) == 0) {
+        *info = cache->info;
+        return cache->parsed;
+    }
+    bool parsed;
+    if (codec == SS4S_VIDEO_H264) {
+        parsed = sps_util_parse_sps_info_h264(sps, sps_size, info);
+    } else {
+        parsed = sps_util_parse_sps_info_hevc(sps, sps_size, info);
+    }
+    if (parsed) {
+        commons_log_info("Media", "SPS: profile %d, level %d, chroma format %d, %d-bit, colour %d/%d/%d%s",
+                         info->profile_idc, info->level_idc, info->chroma_format_idc, info->bit_depth_luma,
+                         info->colour_primaries, info->transfer_characteristics, info->matrix_coefficients,
+                         info->video_full_range_flag ? ", full range" : "");
+    } else {
+        commons_log_warn("Media", "Can't parse SPS.");
+        commons_log_hexdump(COMMONS_LOG_LEVEL_WARN, "Media", sps, sps_size);
+    }
+    if (sps_size <= SPS_CACHE_MAX_SIZE) {
+        cache->hash = hash;
+        cache->size = sps_size;
+        memcpy(cache->data, sps, sps_size);
+        cache->parsed = parsed;
+        cache->info = *info;
+    }
+    return parsed;
+}
+
+/**
+ * FNV-1a
+ */
+static uint32_t sps_hash(const unsigned char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void video_measure_cadence(stream_media_session_t *media_session) {
+    if (media_session->video_cadence_frames > CADENCE_WINDOW_FRAMES) {
+        return;
+    }
+    Uint32 now = SDL_GetTicks();
+    if (media_session->video_cadence_frames++ == 0) {
+        media_session->video_cadence_begin = now;
+        return;
+    }
+    if (media_session->video_cadence_frames <= CADENCE_WINDOW_FRAMES ||
+        SDL_AtomicGet(&media_session->video_frame_rate_from_sps)) {
+        return;
+    }
+    Uint32 elapsed = now - media_session->video_cadence_begin;
+    if (elapsed == 0) {
+        return;
+    }
+    video_request_frame_rate(media_session, CADENCE_WINDOW_FRAMES * 1000.0 / elapsed, "cadence");
+}
+
+static void video_request_frame_rate(stream_media_session_t *media_session, double frame_rate, const char *source) {
+    if (!media_session->manager->app->settings->match_refresh_rate || frame_rate < 1 || frame_rate > 1000) {
+        return;
+    }
+    int mhz = (int) (frame_rate * 1000);
+    int requested = SDL_AtomicGet(&media_session->video_frame_rate_mhz);
+    // Ignore changes within 0.5%, switching display mode is slow and disruptive
+    if (requested != 0 && SDL_abs(mhz - requested) * 200 < requested) {
+        return;
+    }
+    SDL_AtomicSet(&media_session->video_frame_rate_mhz, mhz);
+    commons_log_info("Media", "Stream frame rate %.3f fps (from %s)", frame_rate, source);
+    app_run_on_main(media_session->manager->app, video_match_display_mode, (void *) (intptr_t) mhz);
+}
+
+static void video_match_display_mode(app_t *app, void *data) {
+    double frame_rate = (double) (intptr_t) data / 1000.0;
+    display_mode_match_frame_rate(&app->stream_manager->display_mode, app->window, frame_rate);
+}
+
+static void video_restore_display_mode(app_t *app, void *data) {
+    (void) data;
+    display_mode_restore(&app->stream_manager->display_mode, app->window);
+}
+
+static int video_feeder_worker(void *context) {
+    stream_media_session_t *media_session = (stream_media_session_t *) context;
+    packet_queue_t *queue = media_session->video_queue;
+    video_drop_reason_t dropping = VIDEO_DROP_NONE;
+    while (SDL_AtomicGet(&media_session->video_feeding)) {
+        packet_queue_slot_t *slot = packet_queue_peek(queue, SDL_MUTEX_MAXWAIT);
+        if (slot == NULL) {
+            continue;
+        }
+        bool keyframe = slot->flags & IHS_StreamVideoFrameKeyFrame;
+        if (dropping == VIDEO_DROP_NONE && !keyframe && video_feeder_behind(media_session, slot)) {
+            commons_log_warn("Media", "Decoder fell behind (queued=%u), dropping frames until next keyframe",
+                             (unsigned int) packet_queue_size(queue));
+            SDL_AtomicSet(&media_session->video_keyframe_requested, 1);
+            dropping = VIDEO_DROP_BEHIND;
+        }
+        if (dropping != VIDEO_DROP_NONE && keyframe) {
+            if (dropping == VIDEO_DROP_BEHIND) {
+                media_session->video_recovered_keyframes++;
+            } else {
+                media_session->video_error_recovered_keyframes++;
+            }
+            dropping = VIDEO_DROP_NONE;
+        }
+        if (dropping != VIDEO_DROP_NONE) {
+            media_session->video_dropped++;
+        } else {
+            SS4S_VideoFeedResult result = video_feed_frame(media_session, slot->data, slot->size, slot->flags);
+            if (result != SS4S_VIDEO_FEED_OK && video_feed_failed(media_session, result)) {
+                dropping = VIDEO_DROP_FEED_ERROR;
+            }
+        }
+        packet_queue_pop(queue);
+    }
+    return 0;
+}
+
+static bool video_feeder_behind(const stream_media_session_t *media_session, const packet_queue_slot_t *slot) {
+    const app_settings_t *settings = media_session->manager->app->settings;
+    if (settings->video_drop_max_frames > 0 &&
+        packet_queue_size(media_session->video_queue) > (size_t) settings->video_drop_max_frames) {
+        return true;
+    }
+    if (settings->video_drop_max_age_ms > 0 &&
+        SDL_GetTicks() - slot->timestamp > (Uint32) settings->video_drop_max_age_ms) {
+        return true;
     }
-    return SS4S_PlayerVideoFeed(media_session->player, data->data + data->offset, data->size, sflgs);
+    return false;
 }
 
 static int video_set_capture_size(IHS_Session *session, int width, int height, void *context) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <SDL.h>
+
 #include "ihslib.h"
 
 typedef struct stream_media_session_t stream_media_session_t;
@@ -9,11 +11,13 @@ stream_media_session_t *stream_media_create(stream_manager_t *manager);
 
 void stream_media_destroy(stream_media_session_t *media);
 
-void stream_media_set_viewport_size(stream_media_session_t *media_session, int width, int height);
-
-void stream_media_set_overlay_height(stream_media_session_t *media_session, int height);
+/**
+ * Shrink video to the area above the overlay, or restore it to full screen.
+ * @param area Video area in window pixels, NULL to restore
+ * @param window_height Height of window the area is in
+ */
+void stream_media_set_overlay_shown(stream_media_session_t *media_session, const SDL_Rect *area, int window_height);
 
-void stream_media_set_overlay_shown(stream_media_session_t *media_session, bool overlay);
 bool stream_media_supports_hevc(stream_media_session_t *media_session);
 
 const IHS_StreamAudioCallbacks *stream_media_audio_callbacks();
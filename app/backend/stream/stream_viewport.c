@@ -0,0 +1,78 @@
+#include "stream_viewport.h"
+
+static void update_content(stream_viewport_t *viewport);
+
+static float clamp_unit(float value);
+
+void stream_viewport_set_window_size(stream_viewport_t *viewport, int width, int height) {
+    viewport->window_width = width;
+    viewport->window_height = height;
+    update_content(viewport);
+}
+
+void stream_viewport_set_capture_size(stream_viewport_t *viewport, int width, int height) {
+    viewport->capture_width = width;
+    viewport->capture_height = height;
+    update_content(viewport);
+}
+
+bool stream_viewport_window_to_host(const stream_viewport_t *viewport, int x, int y, float *host_x, float *host_y) {
+    const SDL_Rect *content = &viewport->content;
+    if (content->w <= 0 || content->h <= 0) {
+        return false;
+    }
+    *host_x = clamp_unit((float) (x - content->x) / (float) content->w);
+    *host_y = clamp_unit((float) (y - content->y) / (float) content->h);
+    return true;
+}
+
+bool stream_viewport_host_to_window(const stream_viewport_t *viewport, float x, float y, SDL_Point *point) {
+    const SDL_Rect *content = &viewport->content;
+    if (content->w <= 0 || content->h <= 0) {
+        return false;
+    }
+    point->x = content->x + (int) ((float) content->w * clamp_unit(x));
+    point->y = content->y + (int) ((float) content->h * clamp_unit(y));
+    return true;
+}
+
+bool stream_viewport_overlay_video_area(const stream_viewport_t *viewport, int ui_height, int overlay_height,
+                                        SDL_Rect *area) {
+    int window_width = viewport->window_width, window_height = viewport->window_height;
+    if (window_width <= 0 || window_height <= 0 || ui_height <= 0 || overlay_height <= 0 ||
+        overlay_height >= ui_height) {
+        return false;
+    }
+    int scaled_overlay = (int) ((long long) overlay_height * window_height / ui_height);
+    *area = (SDL_Rect) {.x = 0, .y = 0, .w = window_width, .h = window_height - scaled_overlay};
+    return true;
+}
+
+static void update_content(stream_viewport_t *viewport) {
+    int window_width = viewport->window_width, window_height = viewport->window_height;
+    int capture_width = viewport->capture_width, capture_height = viewport->capture_height;
+    if (capture_width <= 0 || capture_height <= 0 || window_width <= 0 || window_height <= 0) {
+        viewport->content = (SDL_Rect) {.x = 0, .y = 0, .w = window_width, .h = window_height};
+        return;
+    }
+    // Fit capture into window, compare aspect ratios in integers to avoid rounding errors
+    int w, h;
+    if ((long long) window_width * capture_height <= (long long) window_height * capture_width) {
+        w = window_width;
+        h = (int) ((long long) window_width * capture_height / capture_width);
+    } else {
+        w = (int) ((long long) window_height * capture_width / capture_height);
+        h = window_height;
+    }
+    viewport->content = (SDL_Rect) {.x = (window_width - w) / 2, .y = (window_height - h) / 2, .w = w, .h = h};
+}
+
+static float clamp_unit(float value) {
+    if (value < 0) {
+        return 0;
+    }
+    if (value > 1) {
+        return 1;
+    }
+    return value;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL.h>
+
+/**
+ * Where the video is shown in the window. Updated when window or capture size changes, so mapping pointer positions
+ * doesn't need to query SDL for every event.
+ */
+typedef struct stream_viewport_t {
+    /** Window size, in the same coordinates as SDL mouse events */
+    int window_width, window_height;
+    /** Size of host capture, 0 if not known yet */
+    int capture_width, capture_height;
+    /** Area the video is drawn in window, letterboxed to capture aspect ratio. Whole window if capture is unknown */
+    SDL_Rect content;
+} stream_viewport_t;
+
+void stream_viewport_set_window_size(stream_viewport_t *viewport, int width, int height);
+
+void stream_viewport_set_capture_size(stream_viewport_t *viewport, int width, int height);
+
+/**
+ * Map a window position to normalized host position. Positions outside of video area are clamped to the edge.
+ * @return false if window size is unknown
+ */
+bool stream_viewport_window_to_host(const stream_viewport_t *viewport, int x, int y, float *host_x, float *host_y);
+
+/**
+ * Map a normalized host position to window position.
+ * @return false if window size is unknown
+ */
+bool stream_viewport_host_to_window(const stream_viewport_t *viewport, float x, float y, SDL_Point *point);
+
+/**
+ * Area of window left above the overlay. UI may be rendered smaller than the window and scaled up, so overlay height
+ * is converted from UI to window pixels.
+ * @param ui_height Height of UI the overlay is laid out in
+ * @param overlay_height Height of overlay in UI pixels
+ * @return false if window or UI size is unknown
+ */
+bool stream_viewport_overlay_video_area(const stream_viewport_t *viewport, int ui_height, int overlay_height,
+                                        SDL_Rect *area);
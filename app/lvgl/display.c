@@ -2,13 +2,53 @@
 
 #include <src/draw/sdl/lv_draw_sdl.h>
 #include <assert.h>
+#include <string.h>
+
+#include "logging.h"
+
+/** Above this many dirty areas in a refresh cycle, whole screen is presented */
+#define DAMAGE_MAX_RECTS 16
+
+typedef struct app_lv_disp_param_t {
+    /** Must be the first member, as SDL draw backend uses user_data as lv_draw_sdl_drv_param_t */
+    lv_draw_sdl_drv_param_t base;
+    /** Video-only mode is requested, and will be entered after next frame is presented */
+    bool video_only_pending;
+    bool video_only;
+    /** Renderer keeps back buffer content between presents, so only dirty areas need to be copied */
+    bool partial_present;
+    /** Dirty areas flushed since last present */
+    SDL_Rect damage[DAMAGE_MAX_RECTS];
+    int damage_count;
+    bool damage_full;
+    /** Present counters of current one second window */
+    Uint32 stats_begin;
+    uint64_t stats_pixels;
+    uint32_t stats_presents;
+    app_lv_disp_stats_t stats;
+} app_lv_disp_param_t;
 
 static void flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *src);
 
-lv_disp_t *app_lv_disp_init(SDL_Window *window) {
+static void present(app_lv_disp_param_t *param, SDL_Texture *texture, int width, int height);
+
+static void add_damage(app_lv_disp_param_t *param, const lv_area_t *area, int width, int height);
+
+static void update_stats(app_lv_disp_param_t *param, uint64_t pixels);
+
+static bool renderer_supports_partial_present(SDL_Renderer *renderer, int width, int height);
+
+lv_disp_t *app_lv_disp_init(SDL_Window *window, int max_height) {
     int width, height;
     SDL_GetWindowSize(window, &width, &height);
     assert(width > 0 || height > 0);
+    if (max_height > 0 && height > max_height) {
+        // Smaller texture takes less memory and fill-rate, and renderer upscales it with linear filtering
+        commons_log_info("Display", "Render UI at %dx%d, window size %dx%d", width * max_height / height, max_height,
+                         width, height);
+        width = width * max_height / height;
+        height = max_height;
+    }
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
     SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
     lv_disp_draw_buf_t *draw_buf = malloc(sizeof(lv_disp_draw_buf_t));
@@ -17,9 +57,12 @@ lv_disp_t *app_lv_disp_init(SDL_Window *window) {
     lv_disp_drv_t *driver = malloc(sizeof(lv_disp_drv_t));
     lv_disp_drv_init(driver);
 
-    lv_draw_sdl_drv_param_t *param = lv_mem_alloc(sizeof(lv_draw_sdl_drv_param_t));
-    param->renderer = renderer;
-    param->user_data = window;
+    app_lv_disp_param_t *param = lv_mem_alloc(sizeof(app_lv_disp_param_t));
+    lv_memset_00(param, sizeof(app_lv_disp_param_t));
+    param->base.renderer = renderer;
+    param->base.user_data = window;
+    param->partial_present = renderer_supports_partial_present(renderer, width, height);
+    param->stats_begin = SDL_GetTicks();
     driver->user_data = param;
     driver->draw_buf = draw_buf;
     driver->dpi = (int) (width / 5.333333);
@@ -56,25 +99,141 @@ void app_lv_disp_deinit(lv_disp_t *disp) {
     free(drv);
 }
 
+void app_lv_disp_set_video_only(lv_disp_t *disp, bool video_only) {
+    app_lv_disp_param_t *param = disp->driver->user_data;
+    if (video_only) {
+        if (param->video_only || param->video_only_pending) {
+            return;
+        }
+        // Last frame presented may still have UI on it, so present a cleared one before stopping
+        param->video_only_pending = true;
+        lv_obj_invalidate(lv_disp_get_scr_act(disp));
+    } else {
+        param->video_only_pending = false;
+        if (!param->video_only) {
+            return;
+        }
+        param->video_only = false;
+        lv_timer_resume(disp->refr_timer);
+    }
+}
+
+void app_lv_disp_get_stats(lv_disp_t *disp, app_lv_disp_stats_t *stats) {
+    const app_lv_disp_param_t *param = disp->driver->user_data;
+    *stats = param->stats;
+}
+
+void app_lv_disp_window_to_ui(lv_disp_t *disp, int *x, int *y) {
+    const lv_draw_sdl_drv_param_t *param = disp->driver->user_data;
+    int window_width, window_height;
+    SDL_GetWindowSize(param->user_data, &window_width, &window_height);
+    if (window_width <= 0 || window_height <= 0) {
+        return;
+    }
+    *x = *x * disp->driver->hor_res / window_width;
+    *y = *y * disp->driver->ver_res / window_height;
+}
+
 static void flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *src) {
     LV_UNUSED(src);
-    if (area->x2 < 0 || area->y2 < 0 ||
-        area->x1 > disp_drv->hor_res - 1 || area->y1 > disp_drv->ver_res - 1) {
+    app_lv_disp_param_t *param = disp_drv->user_data;
+    if (param->video_only) {
         lv_disp_flush_ready(disp_drv);
         return;
     }
-
+    int width = disp_drv->hor_res, height = disp_drv->ver_res;
+    add_damage(param, area, width, height);
+    // Areas of a refresh cycle are drawn into the screen texture already, so present once after the last one
     if (lv_disp_flush_is_last(disp_drv)) {
-        lv_draw_sdl_drv_param_t *param = disp_drv->user_data;
-        SDL_Renderer *renderer = param->renderer;
-        SDL_Texture *texture = disp_drv->draw_buf->buf1;
-        SDL_SetRenderTarget(renderer, NULL);
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        if (param->damage_count > 0 || param->damage_full) {
+            present(param, disp_drv->draw_buf->buf1, width, height);
+        }
+        param->damage_count = 0;
+        param->damage_full = false;
+        if (param->video_only_pending) {
+            param->video_only_pending = false;
+            param->video_only = true;
+            lv_timer_pause(_lv_refr_get_disp_refreshing()->refr_timer);
+        }
+    }
+    lv_disp_flush_ready(disp_drv);
+}
+
+static void present(app_lv_disp_param_t *param, SDL_Texture *texture, int width, int height) {
+    SDL_Renderer *renderer = param->base.renderer;
+    uint64_t pixels = 0;
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    if (param->partial_present && !param->damage_full) {
+        // Dirty areas are cleared and copied one by one, rest of the back buffer stays as is
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        for (int i = 0; i < param->damage_count; i++) {
+            const SDL_Rect *rect = &param->damage[i];
+            SDL_RenderFillRect(renderer, rect);
+            SDL_RenderCopy(renderer, texture, rect, rect);
+            pixels += (uint64_t) rect->w * rect->h;
+        }
+    } else {
         SDL_RenderClear(renderer);
-        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
         SDL_RenderCopy(renderer, texture, NULL, NULL);
-        SDL_RenderPresent(renderer);
-        SDL_SetRenderTarget(renderer, texture);
+        pixels = (uint64_t) width * height;
     }
-    lv_disp_flush_ready(disp_drv);
-}
\ No newline at end of file
+    SDL_RenderPresent(renderer);
+    SDL_SetRenderTarget(renderer, texture);
+    update_stats(param, pixels);
+}
+
+static void add_damage(app_lv_disp_param_t *param, const lv_area_t *area, int width, int height) {
+    lv_area_t screen = {.x1 = 0, .y1 = 0, .x2 = (lv_coord_t) (width - 1), .y2 = (lv_coord_t) (height - 1)};
+    lv_area_t clipped;
+    if (!_lv_area_intersect(&clipped, area, &screen)) {
+        return;
+    }
+    if (param->damage_full) {
+        return;
+    }
+    if (param->damage_count >= DAMAGE_MAX_RECTS ||
+        (clipped.x1 == 0 && clipped.y1 == 0 && clipped.x2 == screen.x2 && clipped.y2 == screen.y2)) {
+        param->damage_full = true;
+        return;
+    }
+    param->damage[param->damage_count++] = (SDL_Rect) {
+            .x = clipped.x1, .y = clipped.y1,
+            .w = lv_area_get_width(&clipped), .h = lv_area_get_height(&clipped),
+    };
+}
+
+static void update_stats(app_lv_disp_param_t *param, uint64_t pixels) {
+    param->stats.total_pixels += pixels;
+    param->stats.total_presents++;
+    param->stats_pixels += pixels;
+    param->stats_presents++;
+    Uint32 now = SDL_GetTicks(), elapsed = now - param->stats_begin;
+    if (elapsed < 1000) {
+        return;
+    }
+    param->stats.pixels_per_second = (uint32_t) (param->stats_pixels * 1000 / elapsed);
+    param->stats.presents_per_second = param->stats_presents * 1000 / elapsed;
+    commons_log_verbose("Display", "Presented %u pixels/s in %u presents/s", param->stats.pixels_per_second,
+                        param->stats.presents_per_second);
+    param->stats_begin = now;
+    param->stats_pixels = 0;
+    param->stats_presents = 0;
+}
+
+/**
+ * Content of back buffer is undefined after present, unless the renderer draws to the window surface directly.
+ * Dirty areas are copied 1:1, so the output needs to be the same size as the screen texture too.
+ */
+static bool renderer_supports_partial_present(SDL_Renderer *renderer, int width, int height) {
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0 || strcmp(info.name, "software") != 0) {
+        return false;
+    }
+    int output_width, output_height;
+    if (SDL_GetRendererOutputSize(renderer, &output_width, &output_height) != 0) {
+        return false;
+    }
+    return output_width == width && output_height == height;
+}
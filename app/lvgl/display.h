@@ -3,6 +3,31 @@
 #include <lvgl.h>
 #include <SDL.h>
 
-lv_disp_t *app_lv_disp_init(SDL_Window *window);
+typedef struct app_lv_disp_stats_t {
+    uint64_t total_pixels;
+    uint32_t total_presents;
+    /** Pixels copied to the window in last one second window */
+    uint32_t pixels_per_second;
+    uint32_t presents_per_second;
+} app_lv_disp_stats_t;
+
+/**
+ * @param max_height UI is rendered at most this tall, and upscaled when presented. 0 to render at window size
+ */
+lv_disp_t *app_lv_disp_init(SDL_Window *window, int max_height);
 
 void app_lv_disp_deinit(lv_disp_t *disp);
+
+/**
+ * In video-only mode, UI refresh timer is paused and nothing gets presented, so the video doesn't compete with UI
+ * compositing. Entering takes effect after one more (transparent) frame is presented, and leaving resumes refresh
+ * immediately.
+ */
+void app_lv_disp_set_video_only(lv_disp_t *disp, bool video_only);
+
+void app_lv_disp_get_stats(lv_disp_t *disp, app_lv_disp_stats_t *stats);
+
+/**
+ * Convert window coordinates to UI coordinates, as UI may be rendered smaller than the window.
+ */
+void app_lv_disp_window_to_ui(lv_disp_t *disp, int *x, int *y);
@@ -1,4 +1,5 @@
 #include "mouse.h"
+#include "display.h"
 
 #include <SDL.h>
 
@@ -24,6 +25,7 @@ void app_lv_mouse_indev_deinit(lv_indev_t *indev) {
 static void read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data) {
     int x, y;
     Uint32 buttons = SDL_GetMouseState(&x, &y);
+    app_lv_disp_window_to_ui(drv->disp, &x, &y);
     data->state = (buttons & SDL_BUTTON_LEFT) ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
     data->point.x = x;
     data->point.y = y;
@@ -27,8 +27,18 @@
 
 #endif
 
+/**
+ * Longest time main loop sleeps. Everything that needs main thread wakes it up with an event, so this only bounds
+ * the damage of a lost wake up.
+ */
+#define MAIN_LOOP_MAX_WAIT_MS 100
+
 static void process_events();
 
+static void handle_event(const SDL_Event *event);
+
+static void wait_event(uint32_t timeout_ms);
+
 static void logging_init();
 
 static app_t *app = NULL;
@@ -89,11 +99,14 @@ int main(int argc, char *argv[]) {
                                           SDL_WINDOW_ALLOW_HIGHDPI | fullscreen_flag);
     SS4S_PostInit(argc, argv);
 
-    lv_disp_t *disp = app_lv_disp_init(window);
+    lv_disp_t *disp = app_lv_disp_init(window, settings.ui_max_height);
     lv_disp_set_default(disp);
 
     app = app_create(&settings, disp);
     app->os_info = os_info;
+    app->window = window;
+    SDL_GetWindowSize(window, &w, &h);
+    stream_manager_set_window_size(app->stream_manager, w, h);
 
 #if IHSPLAY_FEATURE_LIBCEC
     cec_sdl_ctx_t cec;
@@ -102,11 +115,18 @@ int main(int argc, char *argv[]) {
 
     while (app->running) {
         process_events();
+        uint32_t input_delay = stream_manager_flush_input(app->stream_manager);
+        app_main_tasks_run(app);
         uint32_t next_delay = lv_task_handler();
-        SDL_Delay(stream_manager_is_active(app->stream_manager) ? 1 : next_delay);
+        if (input_delay < next_delay) {
+            next_delay = input_delay;
+        }
+        // Sleep until input, a task from other threads, next LVGL timer or deferred gamepad report is due
+        wait_event(next_delay);
     }
     // Drain remaining events
     process_events();
+    app_main_tasks_run(app);
 
 #if IHSPLAY_FEATURE_LIBCEC
     cec_sdl_deinit(&cec);
@@ -132,53 +152,76 @@ int main(int argc, char *argv[]) {
 static void process_events() {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-            case SDL_KEYUP:
-            case SDL_KEYDOWN:
-            case SDL_MOUSEMOTION:
-            case SDL_MOUSEBUTTONDOWN:
-            case SDL_MOUSEBUTTONUP:
-            case SDL_CONTROLLERAXISMOTION:
-            case SDL_CONTROLLERBUTTONDOWN:
-            case SDL_CONTROLLERBUTTONUP:
-            case SDL_CONTROLLERDEVICEADDED:
-            case SDL_CONTROLLERDEVICEREMOVED: {
-                bool intercept_by_stream = stream_manager_intercept_event(app->stream_manager, &event);
-                if (!intercept_by_stream) {
-                    app_sdl_input_event(app, &event);
-                }
-                stream_manager_handle_event(app->stream_manager, &event);
-                break;
+        handle_event(&event);
+    }
+}
+
+static void wait_event(uint32_t timeout_ms) {
+    if (timeout_ms == 0) {
+        return;
+    }
+    // Also covers LV_NO_TIMER_READY
+    if (timeout_ms > MAIN_LOOP_MAX_WAIT_MS) {
+        timeout_ms = MAIN_LOOP_MAX_WAIT_MS;
+    }
+    SDL_Event event;
+    if (SDL_WaitEventTimeout(&event, (int) timeout_ms)) {
+        handle_event(&event);
+    }
+}
+
+static void handle_event(const SDL_Event *event) {
+    switch (event->type) {
+        case SDL_KEYUP:
+        case SDL_KEYDOWN:
+        case SDL_MOUSEMOTION:
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEWHEEL:
+        case SDL_CONTROLLERAXISMOTION:
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+        case SDL_CONTROLLERDEVICEADDED:
+        case SDL_CONTROLLERDEVICEREMOVED: {
+            bool intercept_by_stream = stream_manager_intercept_event(app->stream_manager, event);
+            if (!intercept_by_stream) {
+                app_sdl_input_event(app, event);
+            }
+            stream_manager_handle_event(app->stream_manager, event);
+            break;
+        }
+        case SDL_WINDOWEVENT: {
+            if (event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                stream_manager_set_window_size(app->stream_manager, event->window.data1, event->window.data2);
             }
-            case SDL_APP_WILLENTERBACKGROUND: {
+            break;
+        }
+        case SDL_APP_WILLENTERBACKGROUND: {
 #if IHSPLAY_FEATURE_FORCE_FULLSCREEN
-                stream_manager_stop_active(app->stream_manager);
+            stream_manager_stop_active(app->stream_manager);
 #endif
-                break;
-            }
-            case SDL_APP_DIDENTERFOREGROUND: {
-                lv_obj_invalidate(lv_scr_act());
-                break;
-            }
-            case SDL_QUIT: {
-                app_quit(app);
-                break;
-            }
-            case APP_RUN_ON_MAIN: {
-                void (*action)(app_t *, void *) = event.user.data1;
-                void *data = event.user.data2;
-                action(app, data);
-                break;
-            }
-            default: {
-                if (event.type > APP_UI_EVENT_BEGIN && event.type < APP_UI_EVENT_LAST) {
-                    app_ui_event_data_t data = {.data1 = event.user.data1, .data2 = event.user.data2};
-                    if (!app_ui_dispatch_event(app->ui, event.type, &data)) {
-                        commons_log_debug("UI", "Unhandled UI event 0x%x", event.type);
-                    }
+            break;
+        }
+        case SDL_APP_DIDENTERFOREGROUND: {
+            lv_obj_invalidate(lv_scr_act());
+            break;
+        }
+        case SDL_QUIT: {
+            app_quit(app);
+            break;
+        }
+        case APP_RUN_ON_MAIN: {
+            // Only wakes up the main loop, tasks are run by app_main_tasks_run
+            break;
+        }
+        default: {
+            if (event->type > APP_UI_EVENT_BEGIN && event->type < APP_UI_EVENT_LAST) {
+                app_ui_event_data_t data = {.data1 = event->user.data1, .data2 = event->user.data2};
+                if (!app_ui_dispatch_event(app->ui, event->type, &data)) {
+                    commons_log_debug("UI", "Unhandled UI event 0x%x", event->type);
                 }
-                break;
             }
+            break;
         }
     }
 }
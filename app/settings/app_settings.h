@@ -7,6 +7,13 @@
 
 typedef struct os_info_t os_info_t;
 
+typedef enum video_feed_policy_t {
+    /** Wait for the decoder to free up a slot, up to the latency bound, then drop the frame */
+    VIDEO_FEED_POLICY_WAIT,
+    /** Drop the incoming frame immediately if the queue is full */
+    VIDEO_FEED_POLICY_DROP,
+} video_feed_policy_t;
+
 typedef struct app_settings_t {
     bool enable_input;
     bool relmouse;
@@ -16,6 +23,30 @@ typedef struct app_settings_t {
     const char *video_driver;
     array_list_t modules;
     uint64_t selected_client_id;
+    /** Number of frames can be queued between network thread and video decoder */
+    int video_queue_depth;
+    /** Maximum time in milliseconds the network thread can be blocked by a full video queue */
+    int video_latency_bound_ms;
+    video_feed_policy_t video_feed_policy;
+    /** Drop frames until next keyframe once this many frames are queued. 0 to disable */
+    int video_drop_max_frames;
+    /** Drop frames until next keyframe once queued frame is older than this. 0 to disable */
+    int video_drop_max_age_ms;
+    /** Switch display refresh rate to match stream frame rate, in fullscreen only */
+    bool match_refresh_rate;
+    /** Bounds of audio latency buffered in sink, adapted to network jitter */
+    int audio_min_latency_ms;
+    int audio_max_latency_ms;
+    /** Run audio decoding thread with real-time priority */
+    bool audio_realtime_priority;
+    /** UI is rendered at most this tall, and upscaled to window size. 0 to render at window size */
+    int ui_max_height;
+    /** Read keyboard and mouse from /dev/input while streaming. Needs IHSPLAY_FEATURE_EVDEV_INPUT */
+    bool evdev_input;
+    /** Append input latency histograms to this file at end of each session. NULL to disable input tracing */
+    const char *input_trace_path;
+    /** Maximum axis reports per second for each game controller. 0 to send every axis motion */
+    int gamepad_report_rate;
 } app_settings_t;
 
 void app_settings_init(app_settings_t *settings, const os_info_t *os_info);
@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include <string.h>
 
 #include "app_settings.h"
@@ -8,6 +9,10 @@
 #include "os_info.h"
 #include "logging.h"
 
+static bool env_enabled(const char *name);
+
+static int env_int(const char *name, int default_value);
+
 void app_settings_init(app_settings_t *settings, const os_info_t *os_info) {
     memset(settings, 0, sizeof(app_settings_t));
     int errno;
@@ -16,6 +21,20 @@ void app_settings_init(app_settings_t *settings, const os_info_t *os_info) {
     }
     settings->enable_input = true;
     settings->relmouse = true;
+    settings->video_queue_depth = env_int("IHSPLAY_VIDEO_QUEUE_DEPTH", 8);
+    settings->video_latency_bound_ms = env_int("IHSPLAY_VIDEO_LATENCY_BOUND_MS", 20);
+    settings->video_feed_policy = env_enabled("IHSPLAY_VIDEO_FEED_DROP") ? VIDEO_FEED_POLICY_DROP
+                                                                        : VIDEO_FEED_POLICY_WAIT;
+    settings->video_drop_max_frames = env_int("IHSPLAY_VIDEO_DROP_MAX_FRAMES", 4);
+    settings->video_drop_max_age_ms = env_int("IHSPLAY_VIDEO_DROP_MAX_AGE_MS", 100);
+    settings->match_refresh_rate = env_enabled("IHSPLAY_MATCH_REFRESH_RATE");
+    settings->audio_min_latency_ms = 20;
+    settings->audio_max_latency_ms = 150;
+    settings->audio_realtime_priority = env_enabled("IHSPLAY_AUDIO_REALTIME");
+    settings->ui_max_height = env_int("IHSPLAY_UI_MAX_HEIGHT", 1080);
+    settings->evdev_input = env_enabled("IHSPLAY_EVDEV_INPUT");
+    settings->input_trace_path = getenv("IHSPLAY_INPUT_TRACE");
+    settings->gamepad_report_rate = env_int("IHSPLAY_GAMEPAD_REPORT_RATE", 500);
 
     SS4S_ModulePreferences preferences = {.audio_module = NULL, .video_module = NULL};
     SS4S_ModuleSelection selection = {.audio_module = NULL, .video_module = NULL};
@@ -28,3 +47,25 @@ void app_settings_init(app_settings_t *settings, const os_info_t *os_info) {
 void app_settings_deinit(app_settings_t *settings) {
     SS4S_ModulesListClear(&settings->modules);
 }
+
+static bool env_enabled(const char *name) {
+    const char *v = getenv(name);
+    if (v == NULL) {
+        return false;
+    }
+    return strcmp(v, "1") == 0 || strcmp(v, "true") == 0;
+}
+
+static int env_int(const char *name, int default_value) {
+    const char *v = getenv(name);
+    if (v == NULL || v[0] == '\0') {
+        return default_value;
+    }
+    char *end = NULL;
+    long value = strtol(v, &end, 10);
+    if (*end != '\0' || value < 0 || value > 65535) {
+        commons_log_warn("Settings", "Invalid value %s=%s", name, v);
+        return default_value;
+    }
+    return (int) value;
+}
@@ -10,6 +10,7 @@
 #include "backend/host_manager.h"
 #include "connection_progress.h"
 #include "backend/input_manager.h"
+#include "lvgl/display.h"
 #include "logging.h"
 #include "config.h"
 
@@ -22,6 +23,7 @@ typedef struct session_fragment_t {
     SDL_Cursor *blank_cursor;
     uint64_t cursor_id;
     bool cursor_visible;
+    bool connected;
 
     lv_fragment_t *overlay;
 
@@ -92,6 +94,10 @@ static void screen_clicked_cb(lv_event_t *e);
 
 static void set_overlay_visible(session_fragment_t *fragment, bool visible);
 
+static void update_render_mode(session_fragment_t *fragment);
+
+static void layer_top_changed_cb(lv_event_t *e);
+
 static void constructor(lv_fragment_t *self, void *args) {
     session_fragment_t *fragment = (session_fragment_t *) self;
     const app_ui_fragment_args_t *fargs = args;
@@ -190,6 +196,8 @@ static void obj_created(lv_fragment_t *self, lv_obj_t *obj) {
     app_ui_set_ignore_keys(fragment->app->ui, true);
 
     lv_obj_set_style_bg_opa(lv_scr_act(), LV_OPA_TRANSP, 0);
+    // Dialogs show up on top layer
+    lv_obj_add_event_cb(lv_layer_top(), layer_top_changed_cb, LV_EVENT_CHILD_CHANGED, fragment);
 }
 
 static void obj_will_delete(lv_fragment_t *self, lv_obj_t *obj) {
@@ -199,6 +207,8 @@ static void obj_will_delete(lv_fragment_t *self, lv_obj_t *obj) {
 
     stream_manager_unregister_listener(fragment->app->stream_manager, &stream_manager_listener);
 
+    lv_obj_remove_event_cb_with_user_data(lv_layer_top(), layer_top_changed_cb, fragment);
+    app_lv_disp_set_video_only(lv_disp_get_default(), false);
     lv_obj_set_style_bg_opa(lv_scr_act(), LV_OPA_COVER, 0);
 }
 
@@ -239,11 +249,15 @@ static void session_connected_main(const IHS_SessionInfo *info, void *context) {
         lv_fragment_manager_remove(fragment->base.child_manager, fragment->overlay);
         fragment->overlay = NULL;
     }
+    fragment->connected = true;
+    update_render_mode(fragment);
 }
 
 static void session_disconnected_main(const IHS_SessionInfo *info, bool requested, void *context) {
     LV_UNUSED(info);
     session_fragment_t *fragment = (session_fragment_t *) context;
+    fragment->connected = false;
+    update_render_mode(fragment);
 //    SDL_SetCursor(SDL_GetDefaultCursor());
     if (!requested) {
         static const char *btn_txts[] = {"OK", ""};
@@ -258,6 +272,7 @@ static void session_overlay_progress(int percentage, void *context) {
     session_fragment_t *fragment = (session_fragment_t *) context;
     if (lv_obj_has_flag(fragment->overlay_hint, LV_OBJ_FLAG_HIDDEN)) {
         lv_obj_clear_flag(fragment->overlay_hint, LV_OBJ_FLAG_HIDDEN);
+        update_render_mode(fragment);
     }
     lv_arc_set_value(fragment->overlay_progress, (int16_t) percentage);
 }
@@ -265,6 +280,7 @@ static void session_overlay_progress(int percentage, void *context) {
 static void session_overlay_progress_finished(bool requested, void *context) {
     session_fragment_t *fragment = (session_fragment_t *) context;
     lv_obj_add_flag(fragment->overlay_hint, LV_OBJ_FLAG_HIDDEN);
+    update_render_mode(fragment);
 }
 
 static void session_show_cursor(IHS_Session *session, float x, float y, void *context) {
@@ -366,6 +382,21 @@ static void set_overlay_visible(session_fragment_t *fragment, bool visible) {
         lv_fragment_manager_remove(fragment->base.child_manager, fragment->overlay);
         fragment->overlay = NULL;
     }
+    update_render_mode(fragment);
+}
+
+/**
+ * When streaming without overlay, hint or dialogs, UI is fully transparent, so rendering it is only a waste.
+ */
+static void update_render_mode(session_fragment_t *fragment) {
+    bool video_only = fragment->connected && fragment->overlay == NULL &&
+                      lv_obj_has_flag(fragment->overlay_hint, LV_OBJ_FLAG_HIDDEN) &&
+                      lv_obj_get_child_cnt(lv_layer_top()) == 0;
+    app_lv_disp_set_video_only(lv_disp_get_default(), video_only);
+}
+
+static void layer_top_changed_cb(lv_event_t *e) {
+    update_render_mode(lv_event_get_user_data(e));
 }
 
 lv_style_t *session_fragment_get_overlay_style(lv_fragment_t *fragment) {
@@ -4,11 +4,17 @@
 #include "app.h"
 #include "ui/app_ui.h"
 #include "backend/stream_manager.h"
+#include "backend/stream/input_trace.h"
 #include "session.h"
 
+#define INPUT_LATENCY_UPDATE_INTERVAL_MS 500
+
 typedef struct streaming_overlay_fragment_t {
     lv_fragment_t base;
     app_t *app;
+    /** Only created when input tracing is enabled */
+    lv_obj_t *input_latency;
+    lv_timer_t *input_latency_timer;
     struct {
     } styles;
 } streaming_overlay_fragment_t;
@@ -21,6 +27,10 @@ static lv_obj_t *create_obj_cb(lv_fragment_t *self, lv_obj_t *container);
 
 static void obj_created_cb(lv_fragment_t *self, lv_obj_t *obj);
 
+static void obj_will_delete_cb(lv_fragment_t *self, lv_obj_t *obj);
+
+static void update_input_latency(lv_timer_t *timer);
+
 static void quit_clicked_cb(lv_event_t *e);
 
 const lv_fragment_class_t streaming_overlay_class = {
@@ -28,6 +38,7 @@ const lv_fragment_class_t streaming_overlay_class = {
         .destructor_cb = destructor_cb,
         .create_obj_cb = create_obj_cb,
         .obj_created_cb = obj_created_cb,
+        .obj_will_delete_cb = obj_will_delete_cb,
         .instance_size = sizeof(streaming_overlay_fragment_t),
 };
 
@@ -58,14 +69,48 @@ static lv_obj_t *create_obj_cb(lv_fragment_t *self, lv_obj_t *container) {
 
     lv_obj_align(quit, LV_ALIGN_LEFT_MID, 0, 0);
 
+    if (stream_manager_get_input_trace(fragment->app->stream_manager) != NULL) {
+        lv_obj_t *input_latency = lv_label_create(content);
+        lv_obj_align(input_latency, LV_ALIGN_RIGHT_MID, 0, 0);
+        fragment->input_latency = input_latency;
+    }
+
     return content;
 }
 
 static void obj_created_cb(lv_fragment_t *self, lv_obj_t *obj) {
+    streaming_overlay_fragment_t *fragment = (streaming_overlay_fragment_t *) self;
+    if (fragment->input_latency != NULL) {
+        fragment->input_latency_timer = lv_timer_create(update_input_latency, INPUT_LATENCY_UPDATE_INTERVAL_MS,
+                                                        fragment);
+        update_input_latency(fragment->input_latency_timer);
+    }
+}
 
+static void obj_will_delete_cb(lv_fragment_t *self, lv_obj_t *obj) {
+    streaming_overlay_fragment_t *fragment = (streaming_overlay_fragment_t *) self;
+    if (fragment->input_latency_timer != NULL) {
+        lv_timer_del(fragment->input_latency_timer);
+        fragment->input_latency_timer = NULL;
+    }
+    fragment->input_latency = NULL;
 }
 
 static void quit_clicked_cb(lv_event_t *e) {
     streaming_overlay_fragment_t *fragment = lv_event_get_user_data(e);
     stream_manager_stop_active(fragment->app->stream_manager);
+}
+
+static void update_input_latency(lv_timer_t *timer) {
+    streaming_overlay_fragment_t *fragment = timer->user_data;
+    const input_trace_t *trace = stream_manager_get_input_trace(fragment->app->stream_manager);
+    if (trace == NULL) {
+        return;
+    }
+    char text[512];
+    if (input_trace_format(trace, text, sizeof(text)) == 0) {
+        lv_label_set_text_static(fragment->input_latency, "No input latency recorded");
+        return;
+    }
+    lv_label_set_text(fragment->input_latency, text);
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+
+#include "completion.h"
+
+struct completion_t {
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    bool done;
+};
+
+static SDL_atomic_t completion_tls = {0};
+static SDL_SpinLock completion_tls_lock = 0;
+
+static void completion_tls_destroy(void *data);
+
+completion_t *completion_get_current() {
+    SDL_TLSID tls = (SDL_TLSID) SDL_AtomicGet(&completion_tls);
+    if (tls == 0) {
+        SDL_AtomicLock(&completion_tls_lock);
+        tls = (SDL_TLSID) SDL_AtomicGet(&completion_tls);
+        if (tls == 0) {
+            tls = SDL_TLSCreate();
+            SDL_AtomicSet(&completion_tls, (int) tls);
+        }
+        SDL_AtomicUnlock(&completion_tls_lock);
+    }
+    completion_t *completion = SDL_TLSGet(tls);
+    if (completion == NULL) {
+        completion = completion_create();
+        SDL_TLSSet(tls, completion, completion_tls_destroy);
+    }
+    completion->done = false;
+    return completion;
+}
+
+completion_t *completion_create() {
+    completion_t *completion = calloc(1, sizeof(completion_t));
+    completion->mutex = SDL_CreateMutex();
+    completion->cond = SDL_CreateCond();
+    return completion;
+}
+
+void completion_destroy(completion_t *completion) {
+    SDL_DestroyMutex(completion->mutex);
+    SDL_DestroyCond(completion->cond);
+    free(completion);
+}
+
+void completion_reset(completion_t *completion) {
+    completion->done = false;
+}
+
+void completion_signal(completion_t *completion) {
+    SDL_LockMutex(completion->mutex);
+    completion->done = true;
+    SDL_CondSignal(completion->cond);
+    SDL_UnlockMutex(completion->mutex);
+}
+
+void completion_wait(completion_t *completion) {
+    SDL_LockMutex(completion->mutex);
+    while (!completion->done) {
+        SDL_CondWait(completion->cond, completion->mutex);
+    }
+    SDL_UnlockMutex(completion->mutex);
+}
+
+static void completion_tls_destroy(void *data) {
+    completion_destroy(data);
+}
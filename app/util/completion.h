@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <SDL.h>
+
+/**
+ * One-shot event a thread blocks on until another thread signals it.
+ *
+ * Each thread has one cached completion, which is reused by every blocking call made on it. A thread can only wait
+ * for one thing at a time, so a single completion per thread is enough, and waiting doesn't allocate.
+ */
+typedef struct completion_t completion_t;
+
+/**
+ * Get completion of calling thread, already reset. It's created on first use, and destroyed when an SDL thread exits.
+ *
+ * Threads not created with SDL_CreateThread never free it, so they should use their own from completion_create.
+ */
+completion_t *completion_get_current();
+
+completion_t *completion_create();
+
+void completion_destroy(completion_t *completion);
+
+/**
+ * Prepare the completion for another wait.
+ */
+void completion_reset(completion_t *completion);
+
+/**
+ * Wake up the thread waiting on the completion. The completion must not be touched after this call.
+ */
+void completion_signal(completion_t *completion);
+
+void completion_wait(completion_t *completion);
@@ -0,0 +1,78 @@
+#include "display_mode.h"
+
+#include "logging.h"
+
+/** Refresh rates up to this multiple of frame rate are considered */
+#define MAX_MULTIPLE 4
+
+static double refresh_rate_error(int refresh_rate, double frame_rate);
+
+bool display_mode_match_frame_rate(display_mode_state_t *state, SDL_Window *window, double frame_rate) {
+    Uint32 flags = SDL_GetWindowFlags(window);
+    if (frame_rate <= 0 || !(flags & SDL_WINDOW_FULLSCREEN)) {
+        return false;
+    }
+    int display = SDL_GetWindowDisplayIndex(window);
+    SDL_DisplayMode current;
+    if (display < 0 || SDL_GetCurrentDisplayMode(display, &current) != 0) {
+        return false;
+    }
+    SDL_DisplayMode best = current;
+    double current_error = current.refresh_rate > 0 ? refresh_rate_error(current.refresh_rate, frame_rate) : 1;
+    double best_error = current_error;
+    for (int i = 0, j = SDL_GetNumDisplayModes(display); i < j; i++) {
+        SDL_DisplayMode mode;
+        if (SDL_GetDisplayMode(display, i, &mode) != 0 || mode.w != current.w || mode.h != current.h ||
+            mode.refresh_rate <= 0) {
+            continue;
+        }
+        double error = refresh_rate_error(mode.refresh_rate, frame_rate);
+        // Modes are sorted from highest refresh rate, so prefer the lower one when they match equally well. Current
+        // mode is kept unless another one is strictly better, to avoid needless switches
+        if (error < current_error && error <= best_error) {
+            best = mode;
+            best_error = error;
+        }
+    }
+    if (best.refresh_rate == current.refresh_rate) {
+        commons_log_info("DisplayMode", "Keep %dHz for %.3f fps", current.refresh_rate, frame_rate);
+        return false;
+    }
+    if (SDL_SetWindowDisplayMode(window, &best) != 0) {
+        commons_log_warn("DisplayMode", "Can't set display mode: %s", SDL_GetError());
+        return false;
+    }
+    if (!state->switched) {
+        state->original = current;
+        state->original_flags = flags & SDL_WINDOW_FULLSCREEN_DESKTOP;
+        state->switched = true;
+    }
+    // Mode of desktop fullscreen windows follows the desktop, so switch to exclusive fullscreen
+    if ((flags & SDL_WINDOW_FULLSCREEN_DESKTOP) == SDL_WINDOW_FULLSCREEN_DESKTOP) {
+        SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
+    }
+    commons_log_info("DisplayMode", "Switched %dHz => %dHz for %.3f fps", current.refresh_rate, best.refresh_rate,
+                     frame_rate);
+    return true;
+}
+
+void display_mode_restore(display_mode_state_t *state, SDL_Window *window) {
+    if (!state->switched) {
+        return;
+    }
+    state->switched = false;
+    SDL_SetWindowDisplayMode(window, &state->original);
+    if (state->original_flags != (SDL_GetWindowFlags(window) & SDL_WINDOW_FULLSCREEN_DESKTOP)) {
+        SDL_SetWindowFullscreen(window, state->original_flags);
+    }
+    commons_log_info("DisplayMode", "Restored %dHz", state->original.refresh_rate);
+}
+
+/**
+ * Relative distance between refresh rate and the nearest integer multiple of frame rate
+ */
+static double refresh_rate_error(int refresh_rate, double frame_rate) {
+    int multiple = SDL_max(SDL_min((int) (refresh_rate / frame_rate + 0.5), MAX_MULTIPLE), 1);
+    double diff = refresh_rate - frame_rate * multiple;
+    return (diff < 0 ? -diff : diff) / refresh_rate;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <SDL.h>
+
+/**
+ * Display mode switched for a stream, so it can be switched back afterwards
+ */
+typedef struct display_mode_state_t {
+    bool switched;
+    SDL_DisplayMode original;
+    Uint32 original_flags;
+} display_mode_state_t;
+
+/**
+ * Switch to the mode with same resolution as the current one, and the refresh rate closest to an integer multiple of
+ * the frame rate. Windowed mode is left as is.
+ * @return true if display mode has been changed
+ */
+bool display_mode_match_frame_rate(display_mode_state_t *state, SDL_Window *window, double frame_rate);
+
+/**
+ * Switch back to the mode before display_mode_match_frame_rate
+ */
+void display_mode_restore(display_mode_state_t *state, SDL_Window *window);
@@ -0,0 +1,43 @@
+#include "mpsc_queue.h"
+
+void mpsc_queue_init(mpsc_queue_t *queue) {
+    queue->stub.next = NULL;
+    queue->tail = &queue->stub;
+    SDL_AtomicSetPtr(&queue->head, &queue->stub);
+}
+
+void mpsc_queue_push(mpsc_queue_t *queue, mpsc_queue_node_t *node) {
+    SDL_AtomicSetPtr(&node->next, NULL);
+    // Producers are serialized by this exchange, and each of them links its predecessor to itself afterwards
+    mpsc_queue_node_t *prev = SDL_AtomicSetPtr(&queue->head, node);
+    SDL_AtomicSetPtr(&prev->next, node);
+}
+
+mpsc_queue_node_t *mpsc_queue_pop(mpsc_queue_t *queue) {
+    mpsc_queue_node_t *tail = queue->tail;
+    mpsc_queue_node_t *next = SDL_AtomicGetPtr(&tail->next);
+    if (tail == &queue->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = SDL_AtomicGetPtr(&next->next);
+    }
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    if (tail != SDL_AtomicGetPtr(&queue->head)) {
+        // A producer has swapped head but not linked it yet
+        return NULL;
+    }
+    // Tail is the only node left. Push the stub behind it, so tail can be taken without emptying the queue
+    mpsc_queue_push(queue, &queue->stub);
+    next = SDL_AtomicGetPtr(&tail->next);
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
+}
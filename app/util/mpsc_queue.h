@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <SDL.h>
+
+/**
+ * Intrusive multi-producer/single-consumer queue.
+ *
+ * Items embed a mpsc_queue_node_t, so pushing never allocates or locks. Any thread can push, but only one thread can
+ * pop at a time.
+ */
+typedef struct mpsc_queue_node_t {
+    /** Accessed with SDL atomics only */
+    void *next;
+} mpsc_queue_node_t;
+
+typedef struct mpsc_queue_t {
+    /** Most recently pushed node, swapped by producers */
+    void *head;
+    /** Consumer side only. Oldest node */
+    mpsc_queue_node_t *tail;
+    /** Placeholder node, so the queue is never really empty */
+    mpsc_queue_node_t stub;
+} mpsc_queue_t;
+
+void mpsc_queue_init(mpsc_queue_t *queue);
+
+void mpsc_queue_push(mpsc_queue_t *queue, mpsc_queue_node_t *node);
+
+/**
+ * Remove the oldest node. Consumer side only.
+ * @return NULL if the queue is empty, or the oldest node is still being pushed
+ */
+mpsc_queue_node_t *mpsc_queue_pop(mpsc_queue_t *queue);
+
+#define mpsc_queue_entry(node, type, member) ((type *) ((char *) (node) - offsetof(type, member)))
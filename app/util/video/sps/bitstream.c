@@ -1,81 +1,79 @@
-
 #include "bitstream.h"
 
+#include <string.h>
+
+static inline void bitstream_refill(bitstream_t *buf);
+
+static inline uint32_t count_leading_zeros(uint64_t value);
 
 void bitstream_init(bitstream_t *buf, const unsigned char *data, size_t size) {
-    buf->data = data;
-    buf->data_size = size;
+    if (size > BITSTREAM_MAX_SIZE) {
+        size = BITSTREAM_MAX_SIZE;
+    }
+    buf->data_size = bitstream_unescape_rbsp(buf->data, data, size);
+    memset(buf->data + buf->data_size, 0, 8);
+    buf->pos = 0;
     buf->offset = 0;
-    buf->consecutive_zeroes = 0;
+    buf->cache = 0;
+    buf->cache_bits = 0;
+}
+
+size_t bitstream_unescape_rbsp(unsigned char *dst, const unsigned char *src, size_t size) {
+    // Whether a byte is an emulation prevention byte only depends on source bytes, so there is no branch in the loop
+    size_t out = 0;
+    for (size_t i = 0; i < size; i++) {
+        unsigned char b = src[i];
+        dst[out] = b;
+        out += !(b == 0x03 && i >= 2 && src[i - 1] == 0 && src[i - 2] == 0);
+    }
+    return out;
 }
 
 bool bitstream_read_bits(bitstream_t *buf, uint32_t size, uint32_t *value) {
     if (size > 32) return false;
-    uint32_t result = 0;
-    for (uint32_t i = 0; i < size; i++) {
-        if ((buf->offset + i) % 8 == 0) {
-            uint32_t byte_index = (buf->offset + i) / 8;
-            if (byte_index >= buf->data_size) {
-                return false;
-            }
-            unsigned char b = buf->data[byte_index];
-            if (b == 0) {
-                buf->consecutive_zeroes++;
-            } else if (b == 0x03 && buf->consecutive_zeroes == 2) {
-                if (++byte_index >= buf->data_size) {
-                    return false;
-                }
-                buf->offset += 8;
-                buf->consecutive_zeroes = buf->data[byte_index] == 0;
-            } else {
-                buf->consecutive_zeroes = 0;
-            }
-        }
-        uint32_t cur_offset = buf->offset + i;
-        uint32_t byte_index = cur_offset / 8;
-        if (byte_index >= buf->data_size) {
-            return false;
-        }
-        uint8_t bit_offset = 7 - cur_offset % 8;
-        result |= (buf->data[byte_index] >> bit_offset & 0x1) << (size - i - 1);
+    if (size == 0) {
+        *value = 0;
+        return true;
+    }
+    if (buf->offset + size > buf->data_size * 8) {
+        return false;
     }
+    if (buf->cache_bits < size) {
+        bitstream_refill(buf);
+    }
+    *value = (uint32_t) (buf->cache >> (64 - size));
+    buf->cache <<= size;
+    buf->cache_bits -= size;
     buf->offset += size;
-    *value = result;
     return true;
 }
 
 
 bool bitstream_skip_bits(bitstream_t *buf, uint32_t size) {
     uint32_t tmp;
-    for (int i = 0; i < size; i += 16) {
-        if (!bitstream_read_bits(buf, size - i < 16 ? size - i : 16, &tmp)) return false;
+    for (uint32_t i = 0; i < size; i += 32) {
+        if (!bitstream_read_bits(buf, size - i < 32 ? size - i : 32, &tmp)) return false;
     }
     return true;
 }
 
 bool bitstream_read_ueg(bitstream_t *buf, uint32_t *value) {
-    uint32_t bitcount = 0;
-    uint32_t tmp;
-
-    for (;;) {
-        if (!bitstream_read_bits(buf, 1, &tmp)) return false;
-        if (tmp == 0) {
-            bitcount++;
-        } else {
-            // bitOffset--;
-            break;
-        }
+    if (buf->cache_bits < 32) {
+        bitstream_refill(buf);
     }
-
-    // bitOffset --;
-    uint32_t result = 0;
-    if (bitcount) {
-        if (!bitstream_read_bits(buf, bitcount, &tmp)) {
-            return false;
-        }
-        result = (uint32_t) ((1 << bitcount) - 1 + tmp);
+    uint32_t bitcount = count_leading_zeros(buf->cache);
+    if (bitcount > 31 || buf->offset + bitcount * 2 + 1 > buf->data_size * 8) {
+        return false;
+    }
+    // Drop leading zeroes, then read them back together with the marker bit
+    buf->cache <<= bitcount;
+    buf->cache_bits -= bitcount;
+    buf->offset += bitcount;
+    uint32_t tmp;
+    if (!bitstream_read_bits(buf, bitcount + 1, &tmp)) {
+        return false;
     }
-    *value = result;
+    *value = tmp - 1;
     return true;
 }
 
@@ -104,3 +102,35 @@ bool bitstream_skip_scaling_list(bitstream_t *buf, uint8_t count) {
     }
     return true;
 }
+
+/**
+ * Fill the cache to at least 56 bits. Data is zero padded, so bytes after end can be loaded safely.
+ */
+static inline void bitstream_refill(bitstream_t *buf) {
+    if (buf->pos >= buf->data_size) {
+        return;
+    }
+    const unsigned char *p = buf->data + buf->pos;
+    uint64_t word = (uint64_t) p[0] << 56 | (uint64_t) p[1] << 48 | (uint64_t) p[2] << 40 | (uint64_t) p[3] << 32 |
+                    (uint64_t) p[4] << 24 | (uint64_t) p[5] << 16 | (uint64_t) p[6] << 8 | (uint64_t) p[7];
+    buf->cache |= word >> buf->cache_bits;
+    uint32_t bytes = (63 - buf->cache_bits) >> 3;
+    buf->pos += bytes;
+    buf->cache_bits += bytes << 3;
+}
+
+static inline uint32_t count_leading_zeros(uint64_t value) {
+    if (value == 0) {
+        return 64;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t) __builtin_clzll(value);
+#else
+    uint32_t count = 0;
+    while (!(value & 0x8000000000000000ULL)) {
+        value <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
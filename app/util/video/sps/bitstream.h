@@ -4,13 +4,29 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/**
+ * Maximum size of RBSP a bitstream can hold. Parameter sets are way smaller than this.
+ */
+#define BITSTREAM_MAX_SIZE 1024
+
 typedef struct bitstream_t {
-    const unsigned char *data;
+    /** RBSP with emulation prevention bytes removed, zero padded for 64-bit loads */
+    unsigned char data[BITSTREAM_MAX_SIZE + 8];
     size_t data_size;
-    uint32_t offset;
-    uint32_t consecutive_zeroes;
+    /** Next byte to be loaded into cache */
+    size_t pos;
+    /** Bits consumed so far */
+    size_t offset;
+    /** Upcoming bits, MSB first */
+    uint64_t cache;
+    /** Number of bits in cache */
+    uint32_t cache_bits;
 } bitstream_t;
 
+/**
+ * Initialize the bitstream with a copy of NAL unit data.
+ * Emulation prevention bytes are removed here, and data larger than BITSTREAM_MAX_SIZE will be truncated.
+ */
 void bitstream_init(bitstream_t *buf, const unsigned char *data, size_t size);
 
 bool bitstream_read_bits(bitstream_t *buf, uint32_t size, uint32_t *value);
@@ -23,6 +39,12 @@ bool bitstream_skip_bits(bitstream_t *buf, uint32_t size);
 
 bool bitstream_skip_scaling_list(bitstream_t *buf, uint8_t count);
 
+/**
+ * Copy data, removing emulation prevention bytes (0x03 in 0x000003).
+ * @return Size of RBSP written to dst, at most size
+ */
+size_t bitstream_unescape_rbsp(unsigned char *dst, const unsigned char *src, size_t size);
+
 static inline bool bitstream_read1(bitstream_t *buf, bool *value) {
     uint32_t tmp;
     if (!bitstream_read_bits(buf, 1, &tmp)) return false;
@@ -57,3 +79,4 @@ static inline bool bitstream_read8(bitstream_t *buf, uint8_t *value) {
     *value = tmp;
     return true;
 }
+
@@ -1,20 +1,16 @@
 #include "common.h"
+#include "start_code.h"
 
 int sps_util_nal_skip_start_code(const unsigned char *data, size_t size, size_t begin) {
-    int consecutive_zeroes = 0;
-    bool found = false;
-    for (size_t i = begin; i < size; ++i) {
-        unsigned char b = data[i];
-        if (found) {
-            return (int) i;
-        } else if (b == 0) {
-            consecutive_zeroes++;
-        } else if (consecutive_zeroes >= 2 && b == 1) {
-            found = true;
-            continue;
-        } else {
-            consecutive_zeroes = 0;
-        }
+    return start_code_find_impl()(data, size, begin);
+}
+
+size_t sps_util_nal_unit_size(const unsigned char *data, size_t size, size_t begin) {
+    int next = sps_util_nal_skip_start_code(data, size, begin);
+    size_t end = next < 0 ? size : (size_t) next - 3;
+    // Leading zero of a 4-byte start code, or trailing_zero_8bits
+    while (end > begin && data[end - 1] == 0) {
+        end--;
     }
-    return -1;
+    return end - begin;
 }
\ No newline at end of file
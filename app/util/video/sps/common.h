@@ -29,4 +29,10 @@
  *
  * @return Index of the first byte of the NAL needed
  */
-int sps_util_nal_skip_start_code(const unsigned char *data, size_t size, size_t begin);
\ No newline at end of file
+int sps_util_nal_skip_start_code(const unsigned char *data, size_t size, size_t begin);
+
+/**
+ *
+ * @return Size of the NAL beginning at begin, until next start code or end of data
+ */
+size_t sps_util_nal_unit_size(const unsigned char *data, size_t size, size_t begin);
\ No newline at end of file
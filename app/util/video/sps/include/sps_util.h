@@ -4,11 +4,92 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#define SPS_UTIL_NAL_INDEX_MAX 32
+
+#define SPS_UTIL_NAL_TYPE_SPS_H264 7
+#define SPS_UTIL_NAL_TYPE_SPS_HEVC 33
+
 typedef struct sps_dimension_t {
     uint16_t width;
     uint16_t height;
 } sps_dimension_t;
 
+typedef struct sps_info_t {
+    /** Size after cropping */
+    sps_dimension_t dimension;
+    uint8_t profile_idc;
+    uint8_t level_idc;
+    /** general_tier_flag for HEVC, always false for H.264 */
+    bool tier_flag;
+    /** 0: monochrome, 1: 4:2:0, 2: 4:2:2, 3: 4:4:4 */
+    uint8_t chroma_format_idc;
+    uint8_t bit_depth_luma;
+    uint8_t bit_depth_chroma;
+    /** Below are from VUI, and left as unspecified (2) or 0 if not present */
+    bool video_full_range_flag;
+    uint8_t colour_primaries;
+    uint8_t transfer_characteristics;
+    uint8_t matrix_coefficients;
+    /** Frame rate is time_scale / num_units_in_tick for HEVC, and half of that for H.264. 0 if not present */
+    uint32_t num_units_in_tick;
+    uint32_t time_scale;
+} sps_info_t;
+
+typedef struct sps_nal_unit_t {
+    uint8_t type;
+    /** nuh_layer_id for HEVC, always 0 for H.264 */
+    uint8_t layer_id;
+    /** TemporalId for HEVC, always 0 for H.264 */
+    uint8_t temporal_id;
+    /** Offset of the NAL unit header in the access unit */
+    uint32_t offset;
+    /** Size of the NAL unit, without start code and trailing zeroes */
+    uint32_t size;
+} sps_nal_unit_t;
+
+typedef struct sps_nal_index_t {
+    sps_nal_unit_t units[SPS_UTIL_NAL_INDEX_MAX];
+    size_t count;
+    /** The access unit has more NAL units than SPS_UTIL_NAL_INDEX_MAX */
+    bool truncated;
+} sps_nal_index_t;
+
+/**
+ * List NAL units in an access unit, with one pass over the data.
+ * @return Number of NAL units indexed
+ */
+size_t sps_util_nal_index_h264(const unsigned char *data, size_t size, sps_nal_index_t *index);
+
+size_t sps_util_nal_index_hevc(const unsigned char *data, size_t size, sps_nal_index_t *index);
+
+/**
+ * @return First NAL unit of the type, or NULL if not found
+ */
+const sps_nal_unit_t *sps_util_nal_index_find(const sps_nal_index_t *index, uint8_t type);
+
 bool sps_util_parse_dimension_h264(const unsigned char *data, size_t size, sps_dimension_t *dimension);
 
-bool sps_util_parse_dimension_hevc(const unsigned char *data, size_t size, sps_dimension_t *dimension);
\ No newline at end of file
+bool sps_util_parse_dimension_hevc(const unsigned char *data, size_t size, sps_dimension_t *dimension);
+
+/**
+ * Find the first SPS NAL unit in an access unit.
+ * @param nal Set to the first byte of the NAL unit (after start code)
+ * @return Size of the NAL unit, or 0 if not found
+ */
+size_t sps_util_find_sps_h264(const unsigned char *data, size_t size, const unsigned char **nal);
+
+size_t sps_util_find_sps_hevc(const unsigned char *data, size_t size, const unsigned char **nal);
+
+/**
+ * Parse a single SPS NAL unit, without start code.
+ */
+bool sps_util_parse_sps_info_h264(const unsigned char *nal, size_t size, sps_info_t *info);
+
+bool sps_util_parse_sps_info_hevc(const unsigned char *nal, size_t size, sps_info_t *info);
+
+/**
+ * Parse dimension from a single SPS NAL unit, without start code.
+ */
+bool sps_util_parse_sps_dimension_h264(const unsigned char *nal, size_t size, sps_dimension_t *dimension);
+
+bool sps_util_parse_sps_dimension_hevc(const unsigned char *nal, size_t size, sps_dimension_t *dimension);
\ No newline at end of file
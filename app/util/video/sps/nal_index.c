@@ -0,0 +1,68 @@
+#include "sps_util.h"
+#include "common.h"
+
+typedef void (*nal_header_fn)(const unsigned char *nal, size_t size, sps_nal_unit_t *unit);
+
+static size_t nal_index(const unsigned char *data, size_t size, sps_nal_index_t *index, nal_header_fn header);
+
+static void nal_header_h264(const unsigned char *nal, size_t size, sps_nal_unit_t *unit);
+
+static void nal_header_hevc(const unsigned char *nal, size_t size, sps_nal_unit_t *unit);
+
+size_t sps_util_nal_index_h264(const unsigned char *data, size_t size, sps_nal_index_t *index) {
+    return nal_index(data, size, index, nal_header_h264);
+}
+
+size_t sps_util_nal_index_hevc(const unsigned char *data, size_t size, sps_nal_index_t *index) {
+    return nal_index(data, size, index, nal_header_hevc);
+}
+
+const sps_nal_unit_t *sps_util_nal_index_find(const sps_nal_index_t *index, uint8_t type) {
+    for (size_t i = 0; i < index->count; i++) {
+        if (index->units[i].type == type) {
+            return &index->units[i];
+        }
+    }
+    return NULL;
+}
+
+static size_t nal_index(const unsigned char *data, size_t size, sps_nal_index_t *index, nal_header_fn header) {
+    index->count = 0;
+    index->truncated = false;
+    int begin = sps_util_nal_skip_start_code(data, size, 0);
+    while (begin >= 0) {
+        if (index->count >= SPS_UTIL_NAL_INDEX_MAX) {
+            index->truncated = true;
+            break;
+        }
+        // Each start code is only searched once, the end of this NAL unit is where next one begins
+        int next = sps_util_nal_skip_start_code(data, size, begin);
+        size_t end = next < 0 ? size : (size_t) next - 3;
+        while (end > (size_t) begin && data[end - 1] == 0) {
+            end--;
+        }
+        sps_nal_unit_t *unit = &index->units[index->count++];
+        unit->offset = (uint32_t) begin;
+        unit->size = (uint32_t) (end - begin);
+        header(data + begin, unit->size, unit);
+        begin = next;
+    }
+    return index->count;
+}
+
+static void nal_header_h264(const unsigned char *nal, size_t size, sps_nal_unit_t *unit) {
+    unit->type = size > 0 ? nal[0] & 0x1F : 0;
+    unit->layer_id = 0;
+    unit->temporal_id = 0;
+}
+
+static void nal_header_hevc(const unsigned char *nal, size_t size, sps_nal_unit_t *unit) {
+    unit->type = size > 0 ? (nal[0] & 0x7E) >> 1 : 0;
+    if (size > 1) {
+        unit->layer_id = (nal[0] & 0x01) << 5 | nal[1] >> 3;
+        unit->temporal_id = (nal[1] & 0x07) > 0 ? (nal[1] & 0x07) - 1 : 0;
+    } else {
+        unit->layer_id = 0;
+        unit->temporal_id = 0;
+    }
+}
\ No newline at end of file
@@ -4,27 +4,48 @@
 
 #define EXTENDED_SAR 255
 
-static bool skip_vui_parameters(bitstream_t *buf);
+static bool parse_vui_parameters(bitstream_t *buf, sps_info_t *info);
 
 static bool skip_hrd_parameters(bitstream_t *buf);
 
 bool sps_util_parse_dimension_h264(const unsigned char *data, size_t size, sps_dimension_t *dimension) {
+    const unsigned char *nal = NULL;
+    size_t nal_size = sps_util_find_sps_h264(data, size, &nal);
+    if (nal_size == 0) {
+        return false;
+    }
+    return sps_util_parse_sps_dimension_h264(nal, nal_size, dimension);
+}
+
+size_t sps_util_find_sps_h264(const unsigned char *data, size_t size, const unsigned char **nal) {
     int begin = 0;
     while ((begin = sps_util_nal_skip_start_code(data, size, begin)) >= 0) {
         if ((data[begin] & 0x1F) == 0x07/* SPS */) {
-            break;
+            *nal = data + begin;
+            return sps_util_nal_unit_size(data, size, begin);
         }
     }
-    if (begin < 0|| begin >= size) {
+    return 0;
+}
+
+bool sps_util_parse_sps_dimension_h264(const unsigned char *nal, size_t size, sps_dimension_t *dimension) {
+    sps_info_t info;
+    if (!sps_util_parse_sps_info_h264(nal, size, &info)) {
         return false;
     }
+    *dimension = info.dimension;
+    return true;
+}
+
+bool sps_util_parse_sps_info_h264(const unsigned char *nal, size_t size, sps_info_t *info) {
     bitstream_t buf;
-    bitstream_init(&buf, data + begin, size - begin);
+    bitstream_init(&buf, nal, size);
 
     uint8_t subwc[] = {1, 2, 2, 1};
     uint8_t subhc[] = {1, 2, 1, 1};
 
     uint32_t chroma_format_idc = 1;
+    uint32_t bit_depth_luma_minus8 = 0, bit_depth_chroma_minus8 = 0;
 
     uint32_t width, height;
 
@@ -39,8 +60,8 @@ bool sps_util_parse_dimension_h264(const unsigned char *data, size_t size, sps_d
     if (!bitstream_skip_bits(&buf, 2))
         return false;
 
-    // level_idc
-    bitstream_skip_bits_checked(&buf, 8);
+    uint8_t level_idc;
+    bitstream_read8_checked(&buf, &level_idc);
 
     uint32_t tmp;
     // id
@@ -58,10 +79,9 @@ bool sps_util_parse_dimension_h264(const unsigned char *data, size_t size, sps_d
             bitstream_skip_bits_checked(&buf, 1);
         }
 
-        // bit_depth_luma_minus8
-        bitstream_read_ueg_checked(&buf, &tmp);
-        // bit_depth_chroma_minus8
-        bitstream_read_ueg_checked(&buf, &tmp);
+        bitstream_read_ueg_checked(&buf, &bit_depth_luma_minus8);
+        bitstream_read_ueg_checked(&buf, &bit_depth_chroma_minus8);
+        if (bit_depth_luma_minus8 > 6 || bit_depth_chroma_minus8 > 6) return false;
         // qpprime_y_zero_transform_bypass_flag
         bitstream_skip_bits_checked(&buf, 1);
 
@@ -132,10 +152,21 @@ bool sps_util_parse_dimension_h264(const unsigned char *data, size_t size, sps_d
         bitstream_read_ueg_checked(&buf, &frame_crop_bottom_offset);
     }
 
+    *info = (sps_info_t) {
+            .profile_idc = profile_idc,
+            .level_idc = level_idc,
+            .chroma_format_idc = chroma_format_idc,
+            .bit_depth_luma = bit_depth_luma_minus8 + 8,
+            .bit_depth_chroma = bit_depth_chroma_minus8 + 8,
+            .colour_primaries = 2,
+            .transfer_characteristics = 2,
+            .matrix_coefficients = 2,
+    };
+
     bool vui_parameters_present_flag = false;
     bitstream_read1_checked(&buf, &vui_parameters_present_flag);
     if (vui_parameters_present_flag) {
-        if (!skip_vui_parameters(&buf)) return false;
+        if (!parse_vui_parameters(&buf, info)) return false;
     }
 
     /* Calculate width and height */
@@ -156,12 +187,12 @@ bool sps_util_parse_dimension_h264(const unsigned char *data, size_t size, sps_d
         return false;
     }
 
-    dimension->width = width;
-    dimension->height = height;
+    info->dimension.width = width;
+    info->dimension.height = height;
     return true;
 }
 
-static bool skip_vui_parameters(bitstream_t *buf) {
+static bool parse_vui_parameters(bitstream_t *buf, sps_info_t *info) {
     bool aspect_ratio_info_present_flag = false;
     bitstream_read1_checked(buf, &aspect_ratio_info_present_flag);
     if (aspect_ratio_info_present_flag) {
@@ -187,31 +218,31 @@ static bool skip_vui_parameters(bitstream_t *buf) {
     if (video_signal_type_present_flag) {
         // video_format
         bitstream_skip_bits(buf, 3);
-        // video_full_range_flag
-        bitstream_skip_bits(buf, 1);
+        bitstream_read1_checked(buf, &info->video_full_range_flag);
         bool colour_description_present_flag = false;
         bitstream_read1_checked(buf, &colour_description_present_flag);
         if (colour_description_present_flag) {
-            bitstream_skip_bits(buf, 8);
-            bitstream_skip_bits(buf, 8);
-            bitstream_skip_bits(buf, 8);
+            bitstream_read8_checked(buf, &info->colour_primaries);
+            bitstream_read8_checked(buf, &info->transfer_characteristics);
+            bitstream_read8_checked(buf, &info->matrix_coefficients);
         }
     }
 
     bool chroma_loc_info_present_flag = false;
     bitstream_read1_checked(buf, &chroma_loc_info_present_flag);
     if (chroma_loc_info_present_flag) {
-        bitstream_skip_bits(buf, 5);
-        bitstream_skip_bits(buf, 5);
+        uint32_t tmp;
+        // chroma_sample_loc_type_top_field
+        bitstream_read_ueg_checked(buf, &tmp);
+        // chroma_sample_loc_type_bottom_field
+        bitstream_read_ueg_checked(buf, &tmp);
     }
 
     bool timing_info_present_flag = false;
     bitstream_read1_checked(buf, &timing_info_present_flag);
     if (timing_info_present_flag) {
-        // num_units_in_tick
-        bitstream_skip_bits(buf, 32);
-        // time_scale
-        bitstream_skip_bits(buf, 32);
+        if (!bitstream_read_bits(buf, 32, &info->num_units_in_tick)) return false;
+        if (!bitstream_read_bits(buf, 32, &info->time_scale)) return false;
         // fixed_frame_rate_flag
         bitstream_skip_bits(buf, 1);
     }
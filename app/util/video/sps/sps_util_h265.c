@@ -8,22 +8,48 @@
 
 #define EXTENDED_SAR 255
 
-static bool parse_profile_info(bitstream_t *buf);
+static bool parse_profile_info(bitstream_t *buf, sps_info_t *info);
 
-static bool parse_profile_tier_level(bitstream_t *buf, uint8_t max_sub_layers_minus1);
+static bool parse_profile_tier_level(bitstream_t *buf, uint8_t max_sub_layers_minus1, sps_info_t *info);
+
+static bool skip_scaling_list_data(bitstream_t *buf);
+
+static bool skip_st_ref_pic_set(bitstream_t *buf, uint32_t idx, uint32_t *num_delta_pocs);
+
+static bool parse_vui_parameters(bitstream_t *buf, sps_info_t *info);
 
 bool sps_util_parse_dimension_hevc(const unsigned char *data, size_t size, sps_dimension_t *dimension) {
+    const unsigned char *nal = NULL;
+    size_t nal_size = sps_util_find_sps_hevc(data, size, &nal);
+    if (nal_size == 0) {
+        return false;
+    }
+    return sps_util_parse_sps_dimension_hevc(nal, nal_size, dimension);
+}
+
+size_t sps_util_find_sps_hevc(const unsigned char *data, size_t size, const unsigned char **nal) {
     int begin = 0;
     while ((begin = sps_util_nal_skip_start_code(data, size, begin)) >= 0) {
         if ((data[begin] & 0x7E) >> 1 == 33/* SPS */) {
-            break;
+            *nal = data + begin;
+            return sps_util_nal_unit_size(data, size, begin);
         }
     }
-    if (begin < 0 || begin >= size) {
+    return 0;
+}
+
+bool sps_util_parse_sps_dimension_hevc(const unsigned char *nal, size_t size, sps_dimension_t *dimension) {
+    sps_info_t info;
+    if (!sps_util_parse_sps_info_hevc(nal, size, &info)) {
         return false;
     }
+    *dimension = info.dimension;
+    return true;
+}
+
+bool sps_util_parse_sps_info_hevc(const unsigned char *nal, size_t size, sps_info_t *info) {
     bitstream_t buf;
-    bitstream_init(&buf, data + begin, size - begin);
+    bitstream_init(&buf, nal, size);
 
     uint8_t subwc[] = {1, 2, 2, 1, 1};
     uint8_t subhc[] = {1, 2, 1, 1, 1};
@@ -32,14 +58,23 @@ bool sps_util_parse_dimension_hevc(const unsigned char *data, size_t size, sps_d
 
     uint32_t tmp;
 
+    *info = (sps_info_t) {
+            .colour_primaries = 2,
+            .transfer_characteristics = 2,
+            .matrix_coefficients = 2,
+    };
+
+    // nal_unit_header
+    bitstream_skip_bits_checked(&buf, 16);
     // sps_video_parameter_set_id
     bitstream_skip_bits_checked(&buf, 4);
     // sps_max_sub_layers_minus1
     bitstream_read3_checked(&buf, &max_sub_layers_minus1);
+    if (max_sub_layers_minus1 > 6) return false;
     // sps_temporal_id_nesting_flag
     bitstream_skip_bits(&buf, 1);
 
-    if (!parse_profile_tier_level(&buf, max_sub_layers_minus1)) {
+    if (!parse_profile_tier_level(&buf, max_sub_layers_minus1, info)) {
         return false;
     }
 
@@ -48,10 +83,12 @@ bool sps_util_parse_dimension_hevc(const unsigned char *data, size_t size, sps_d
 
     uint32_t chroma_format_idc;
     if (!bitstream_read_ueg(&buf, &chroma_format_idc)) return false;
+    if (chroma_format_idc > 3) return false;
     if (chroma_format_idc == 3) {
         // separate_colour_plane_flag:1
         bitstream_skip_bits(&buf, 1);
     }
+    info->chroma_format_idc = chroma_format_idc;
 
     uint32_t pic_width_in_luma_samples;
     uint32_t pic_height_in_luma_samples;
@@ -82,23 +119,119 @@ bool sps_util_parse_dimension_hevc(const unsigned char *data, size_t size, sps_d
         return false;
     }
 
-    dimension->width = width;
-    dimension->height = height;
+    info->dimension.width = width;
+    info->dimension.height = height;
+
+    uint32_t bit_depth_luma_minus8, bit_depth_chroma_minus8;
+    bitstream_read_ueg_checked(&buf, &bit_depth_luma_minus8);
+    bitstream_read_ueg_checked(&buf, &bit_depth_chroma_minus8);
+    if (bit_depth_luma_minus8 > 8 || bit_depth_chroma_minus8 > 8) return false;
+    info->bit_depth_luma = bit_depth_luma_minus8 + 8;
+    info->bit_depth_chroma = bit_depth_chroma_minus8 + 8;
+
+    uint32_t log2_max_pic_order_cnt_lsb_minus4;
+    bitstream_read_ueg_checked(&buf, &log2_max_pic_order_cnt_lsb_minus4);
+    if (log2_max_pic_order_cnt_lsb_minus4 > 12) return false;
+
+    bool sub_layer_ordering_info_present_flag;
+    bitstream_read1_checked(&buf, &sub_layer_ordering_info_present_flag);
+    for (int i = sub_layer_ordering_info_present_flag ? 0 : max_sub_layers_minus1; i <= max_sub_layers_minus1; i++) {
+        // sps_max_dec_pic_buffering_minus1[i]
+        bitstream_read_ueg_checked(&buf, &tmp);
+        // sps_max_num_reorder_pics[i]
+        bitstream_read_ueg_checked(&buf, &tmp);
+        // sps_max_latency_increase_plus1[i]
+        bitstream_read_ueg_checked(&buf, &tmp);
+    }
+
+    // log2_min_luma_coding_block_size_minus3
+    bitstream_read_ueg_checked(&buf, &tmp);
+    // log2_diff_max_min_luma_coding_block_size
+    bitstream_read_ueg_checked(&buf, &tmp);
+    // log2_min_luma_transform_block_size_minus2
+    bitstream_read_ueg_checked(&buf, &tmp);
+    // log2_diff_max_min_luma_transform_block_size
+    bitstream_read_ueg_checked(&buf, &tmp);
+    // max_transform_hierarchy_depth_inter
+    bitstream_read_ueg_checked(&buf, &tmp);
+    // max_transform_hierarchy_depth_intra
+    bitstream_read_ueg_checked(&buf, &tmp);
+
+    bool scaling_list_enabled_flag;
+    bitstream_read1_checked(&buf, &scaling_list_enabled_flag);
+    if (scaling_list_enabled_flag) {
+        bool sps_scaling_list_data_present_flag;
+        bitstream_read1_checked(&buf, &sps_scaling_list_data_present_flag);
+        if (sps_scaling_list_data_present_flag) {
+            CHECK_RETURN(skip_scaling_list_data(&buf));
+        }
+    }
+
+    // amp_enabled_flag
+    bitstream_skip_bits_checked(&buf, 1);
+    // sample_adaptive_offset_enabled_flag
+    bitstream_skip_bits_checked(&buf, 1);
+
+    bool pcm_enabled_flag;
+    bitstream_read1_checked(&buf, &pcm_enabled_flag);
+    if (pcm_enabled_flag) {
+        // pcm_sample_bit_depth_luma_minus1:4, pcm_sample_bit_depth_chroma_minus1:4
+        bitstream_skip_bits_checked(&buf, 8);
+        // log2_min_pcm_luma_coding_block_size_minus3
+        bitstream_read_ueg_checked(&buf, &tmp);
+        // log2_diff_max_min_pcm_luma_coding_block_size
+        bitstream_read_ueg_checked(&buf, &tmp);
+        // pcm_loop_filter_disabled_flag
+        bitstream_skip_bits_checked(&buf, 1);
+    }
+
+    uint32_t num_short_term_ref_pic_sets;
+    bitstream_read_ueg_checked(&buf, &num_short_term_ref_pic_sets);
+    if (num_short_term_ref_pic_sets > 64) return false;
+    uint32_t num_delta_pocs = 0;
+    for (uint32_t i = 0; i < num_short_term_ref_pic_sets; i++) {
+        CHECK_RETURN(skip_st_ref_pic_set(&buf, i, &num_delta_pocs));
+    }
+
+    bool long_term_ref_pics_present_flag;
+    bitstream_read1_checked(&buf, &long_term_ref_pics_present_flag);
+    if (long_term_ref_pics_present_flag) {
+        uint32_t num_long_term_ref_pics_sps;
+        bitstream_read_ueg_checked(&buf, &num_long_term_ref_pics_sps);
+        if (num_long_term_ref_pics_sps > 32) return false;
+        for (uint32_t i = 0; i < num_long_term_ref_pics_sps; i++) {
+            // lt_ref_pic_poc_lsb_sps[i], used_by_curr_pic_lt_sps_flag[i]
+            bitstream_skip_bits_checked(&buf, log2_max_pic_order_cnt_lsb_minus4 + 4 + 1);
+        }
+    }
+
+    // sps_temporal_mvp_enabled_flag
+    bitstream_skip_bits_checked(&buf, 1);
+    // strong_intra_smoothing_enabled_flag
+    bitstream_skip_bits_checked(&buf, 1);
+
+    bool vui_parameters_present_flag;
+    bitstream_read1_checked(&buf, &vui_parameters_present_flag);
+    if (vui_parameters_present_flag) {
+        CHECK_RETURN(parse_vui_parameters(&buf, info));
+    }
     return true;
 }
 
-static bool parse_profile_info(bitstream_t *buf) {
+static bool parse_profile_info(bitstream_t *buf, sps_info_t *info) {
     // profile_space:2
     bitstream_skip_bits_checked(buf, 2);
-    // tier_flag:1
-    bitstream_skip_bits_checked(buf, 1);
-    // profile_idc:5
-    bitstream_skip_bits_checked(buf, 5);
-
-    for (int i = 0; i < 32; i++) {
-        // profile_compatibility_flag[i]
-        bitstream_skip_bits_checked(buf, 1);
+    bool tier_flag;
+    bitstream_read1_checked(buf, &tier_flag);
+    uint32_t profile_idc;
+    if (!bitstream_read_bits(buf, 5, &profile_idc)) return false;
+    if (info != NULL) {
+        info->tier_flag = tier_flag;
+        info->profile_idc = profile_idc;
     }
+
+    // profile_compatibility_flag[32]
+    bitstream_skip_bits_checked(buf, 32);
     // progressive_source_flag
     bitstream_skip_bits_checked(buf, 1);
     // interlaced_source_flag
@@ -113,14 +246,13 @@ static bool parse_profile_info(bitstream_t *buf) {
     return true;
 }
 
-static bool parse_profile_tier_level(bitstream_t *buf, uint8_t max_sub_layers_minus1) {
-    bool sub_layer_profile_present_flag[6];
-    bool sub_layer_level_present_flag[6];
+static bool parse_profile_tier_level(bitstream_t *buf, uint8_t max_sub_layers_minus1, sps_info_t *info) {
+    bool sub_layer_profile_present_flag[7];
+    bool sub_layer_level_present_flag[7];
 
-    CHECK_RETURN(parse_profile_info(buf));
+    CHECK_RETURN(parse_profile_info(buf, info));
 
-    // level_idc
-    bitstream_skip_bits(buf, 8);
+    bitstream_read8_checked(buf, &info->level_idc);
 
     for (int i = 0; i < max_sub_layers_minus1; i++) {
         bitstream_read1_checked(buf, &sub_layer_profile_present_flag[i]);
@@ -136,7 +268,7 @@ static bool parse_profile_tier_level(bitstream_t *buf, uint8_t max_sub_layers_mi
 
     for (int i = 0; i < max_sub_layers_minus1; i++) {
         if (sub_layer_profile_present_flag[i]) {
-            CHECK_RETURN(parse_profile_info(buf));
+            CHECK_RETURN(parse_profile_info(buf, NULL));
         }
 
         if (sub_layer_level_present_flag[i]) {
@@ -145,4 +277,144 @@ static bool parse_profile_tier_level(bitstream_t *buf, uint8_t max_sub_layers_mi
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+static bool skip_scaling_list_data(bitstream_t *buf) {
+    uint32_t tmp;
+    int32_t delta;
+    for (int size_id = 0; size_id < 4; size_id++) {
+        for (int matrix_id = 0; matrix_id < 6; matrix_id += (size_id == 3) ? 3 : 1) {
+            bool scaling_list_pred_mode_flag;
+            bitstream_read1_checked(buf, &scaling_list_pred_mode_flag);
+            if (!scaling_list_pred_mode_flag) {
+                // scaling_list_pred_matrix_id_delta
+                bitstream_read_ueg_checked(buf, &tmp);
+                continue;
+            }
+            int coef_num = 1 << (4 + (size_id << 1));
+            if (coef_num > 64) coef_num = 64;
+            if (size_id > 1) {
+                // scaling_list_dc_coef_minus8
+                bitstream_read_eg_checked(buf, &delta);
+            }
+            for (int i = 0; i < coef_num; i++) {
+                // scaling_list_delta_coef
+                bitstream_read_eg_checked(buf, &delta);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @param num_delta_pocs NumDeltaPocs of the previous set on input, and of this set on output
+ */
+static bool skip_st_ref_pic_set(bitstream_t *buf, uint32_t idx, uint32_t *num_delta_pocs) {
+    uint32_t tmp;
+    bool inter_ref_pic_set_prediction_flag = false;
+    if (idx != 0) {
+        bitstream_read1_checked(buf, &inter_ref_pic_set_prediction_flag);
+    }
+    if (inter_ref_pic_set_prediction_flag) {
+        // delta_rps_sign
+        bitstream_skip_bits_checked(buf, 1);
+        // abs_delta_rps_minus1
+        bitstream_read_ueg_checked(buf, &tmp);
+        // Sets in SPS are always predicted from the previous one
+        uint32_t count = 0;
+        for (uint32_t j = 0; j <= *num_delta_pocs; j++) {
+            bool used_by_curr_pic_flag, use_delta_flag = true;
+            bitstream_read1_checked(buf, &used_by_curr_pic_flag);
+            if (!used_by_curr_pic_flag) {
+                bitstream_read1_checked(buf, &use_delta_flag);
+            }
+            if (used_by_curr_pic_flag || use_delta_flag) {
+                count++;
+            }
+        }
+        *num_delta_pocs = count;
+    } else {
+        uint32_t num_negative_pics, num_positive_pics;
+        bitstream_read_ueg_checked(buf, &num_negative_pics);
+        bitstream_read_ueg_checked(buf, &num_positive_pics);
+        if (num_negative_pics > 16 || num_positive_pics > 16) return false;
+        for (uint32_t i = 0; i < num_negative_pics + num_positive_pics; i++) {
+            // delta_poc_s[01]_minus1[i]
+            bitstream_read_ueg_checked(buf, &tmp);
+            // used_by_curr_pic_s[01]_flag[i]
+            bitstream_skip_bits_checked(buf, 1);
+        }
+        *num_delta_pocs = num_negative_pics + num_positive_pics;
+    }
+    return true;
+}
+
+static bool parse_vui_parameters(bitstream_t *buf, sps_info_t *info) {
+    uint32_t tmp;
+    bool aspect_ratio_info_present_flag;
+    bitstream_read1_checked(buf, &aspect_ratio_info_present_flag);
+    if (aspect_ratio_info_present_flag) {
+        uint8_t aspect_ratio_idc;
+        bitstream_read8_checked(buf, &aspect_ratio_idc);
+        if (aspect_ratio_idc == EXTENDED_SAR) {
+            // sar_width, sar_height
+            bitstream_skip_bits_checked(buf, 32);
+        }
+    }
+
+    bool overscan_info_present_flag;
+    bitstream_read1_checked(buf, &overscan_info_present_flag);
+    if (overscan_info_present_flag) {
+        // overscan_appropriate_flag
+        bitstream_skip_bits_checked(buf, 1);
+    }
+
+    bool video_signal_type_present_flag;
+    bitstream_read1_checked(buf, &video_signal_type_present_flag);
+    if (video_signal_type_present_flag) {
+        // video_format
+        bitstream_skip_bits_checked(buf, 3);
+        bitstream_read1_checked(buf, &info->video_full_range_flag);
+        bool colour_description_present_flag;
+        bitstream_read1_checked(buf, &colour_description_present_flag);
+        if (colour_description_present_flag) {
+            bitstream_read8_checked(buf, &info->colour_primaries);
+            bitstream_read8_checked(buf, &info->transfer_characteristics);
+            bitstream_read8_checked(buf, &info->matrix_coefficients);
+        }
+    }
+
+    bool chroma_loc_info_present_flag;
+    bitstream_read1_checked(buf, &chroma_loc_info_present_flag);
+    if (chroma_loc_info_present_flag) {
+        // chroma_sample_loc_type_top_field
+        bitstream_read_ueg_checked(buf, &tmp);
+        // chroma_sample_loc_type_bottom_field
+        bitstream_read_ueg_checked(buf, &tmp);
+    }
+
+    // neutral_chroma_indication_flag
+    bitstream_skip_bits_checked(buf, 1);
+    // field_seq_flag
+    bitstream_skip_bits_checked(buf, 1);
+    // frame_field_info_present_flag
+    bitstream_skip_bits_checked(buf, 1);
+
+    bool default_display_window_flag;
+    bitstream_read1_checked(buf, &default_display_window_flag);
+    if (default_display_window_flag) {
+        for (int i = 0; i < 4; i++) {
+            // def_disp_win_(left|right|top|bottom)_offset
+            bitstream_read_ueg_checked(buf, &tmp);
+        }
+    }
+
+    bool vui_timing_info_present_flag;
+    bitstream_read1_checked(buf, &vui_timing_info_present_flag);
+    if (vui_timing_info_present_flag) {
+        if (!bitstream_read_bits(buf, 32, &info->num_units_in_tick)) return false;
+        if (!bitstream_read_bits(buf, 32, &info->time_scale)) return false;
+    }
+    // Nothing needed after timing info
+    return true;
+}
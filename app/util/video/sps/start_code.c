@@ -0,0 +1,90 @@
+#include "start_code.h"
+
+#include <stdbool.h>
+
+#if SPS_UTIL_HAVE_NEON && defined(__arm__) && defined(__linux__)
+
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+#endif
+
+#if SPS_UTIL_HAVE_SSE2
+
+static bool cpu_has_sse2();
+
+#endif
+
+#if SPS_UTIL_HAVE_NEON
+
+static bool cpu_has_neon();
+
+#endif
+
+int start_code_find_scalar(const unsigned char *data, size_t size, size_t begin) {
+    int consecutive_zeroes = 0;
+    bool found = false;
+    for (size_t i = begin; i < size; ++i) {
+        unsigned char b = data[i];
+        if (found) {
+            return (int) i;
+        } else if (b == 0) {
+            consecutive_zeroes++;
+        } else if (consecutive_zeroes >= 2 && b == 1) {
+            found = true;
+            continue;
+        } else {
+            consecutive_zeroes = 0;
+        }
+    }
+    return -1;
+}
+
+start_code_find_fn start_code_find_impl() {
+    // Racing on this is harmless, as every thread will resolve to the same function
+    static start_code_find_fn resolved = NULL;
+    if (resolved != NULL) {
+        return resolved;
+    }
+    start_code_find_fn impl = start_code_find_scalar;
+#if SPS_UTIL_HAVE_SSE2
+    if (cpu_has_sse2()) {
+        impl = start_code_find_sse2;
+    }
+#endif
+#if SPS_UTIL_HAVE_NEON
+    if (cpu_has_neon()) {
+        impl = start_code_find_neon;
+    }
+#endif
+    resolved = impl;
+    return impl;
+}
+
+#if SPS_UTIL_HAVE_SSE2
+
+static bool cpu_has_sse2() {
+#if defined(__x86_64__)
+    return true;
+#elif defined(__GNUC__)
+    return __builtin_cpu_supports("sse2");
+#else
+    return false;
+#endif
+}
+
+#endif
+
+#if SPS_UTIL_HAVE_NEON
+
+static bool cpu_has_neon() {
+#if defined(__aarch64__)
+    return true;
+#elif defined(__arm__) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+    return false;
+#endif
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Find 00 00 01 start code at or after begin. Zero bytes before begin are not counted.
+ *
+ * @return Index of the first byte after the start code, or -1 if not found
+ */
+typedef int (*start_code_find_fn)(const unsigned char *data, size_t size, size_t begin);
+
+int start_code_find_scalar(const unsigned char *data, size_t size, size_t begin);
+
+#if SPS_UTIL_HAVE_SSE2
+
+int start_code_find_sse2(const unsigned char *data, size_t size, size_t begin);
+
+#endif
+
+#if SPS_UTIL_HAVE_NEON
+
+int start_code_find_neon(const unsigned char *data, size_t size, size_t begin);
+
+#endif
+
+/**
+ * @return Fastest implementation supported by current CPU
+ */
+start_code_find_fn start_code_find_impl();
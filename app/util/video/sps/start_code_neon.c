@@ -0,0 +1,21 @@
+#include "start_code.h"
+
+#include <arm_neon.h>
+
+int start_code_find_neon(const unsigned char *data, size_t size, size_t begin) {
+    // Position of the 01 byte. Zero bytes before begin don't count, so it's at least begin + 2
+    size_t i = begin + 2;
+    const uint8x16_t zero = vdupq_n_u8(0), one = vdupq_n_u8(1);
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t zero2 = vceqq_u8(vld1q_u8(data + i - 2), zero);
+        uint8x16_t zero1 = vceqq_u8(vld1q_u8(data + i - 1), zero);
+        uint8x16_t one0 = vceqq_u8(vld1q_u8(data + i), one);
+        uint8x16_t match = vandq_u8(vandq_u8(zero2, zero1), one0);
+        uint64x2_t match64 = vreinterpretq_u64_u8(match);
+        if ((vgetq_lane_u64(match64, 0) | vgetq_lane_u64(match64, 1)) != 0) {
+            // No movemask on NEON, the block is small enough to locate the match with scalar code
+            break;
+        }
+    }
+    return start_code_find_scalar(data, size, i - 2);
+}
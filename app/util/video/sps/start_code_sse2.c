@@ -0,0 +1,20 @@
+#include "start_code.h"
+
+#include <emmintrin.h>
+
+int start_code_find_sse2(const unsigned char *data, size_t size, size_t begin) {
+    // Position of the 01 byte. Zero bytes before begin don't count, so it's at least begin + 2
+    size_t i = begin + 2;
+    const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8(1);
+    for (; i + 16 <= size; i += 16) {
+        __m128i zero2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (data + i - 2)), zero);
+        __m128i zero1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (data + i - 1)), zero);
+        __m128i one0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (data + i)), one);
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(zero2, zero1), one0));
+        if (mask != 0) {
+            size_t next = i + __builtin_ctz((unsigned int) mask) + 1;
+            return next < size ? (int) next : -1;
+        }
+    }
+    return start_code_find_scalar(data, size, i - 2);
+}
@@ -0,0 +1,181 @@
+/**
+ * Compares bitstream reader against the previous bit-by-bit implementation.
+ * Usage: bench_bitstream [iterations]
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bitstream.h"
+
+typedef struct legacy_bitstream_t {
+    const unsigned char *data;
+    size_t data_size;
+    uint32_t offset;
+    uint32_t consecutive_zeroes;
+} legacy_bitstream_t;
+
+static void legacy_init(legacy_bitstream_t *buf, const unsigned char *data, size_t size) {
+    buf->data = data;
+    buf->data_size = size;
+    buf->offset = 0;
+    buf->consecutive_zeroes = 0;
+}
+
+static bool legacy_read_bits(legacy_bitstream_t *buf, uint32_t size, uint32_t *value) {
+    if (size > 32) return false;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        if ((buf->offset + i) % 8 == 0) {
+            uint32_t byte_index = (buf->offset + i) / 8;
+            if (byte_index >= buf->data_size) {
+                return false;
+            }
+            unsigned char b = buf->data[byte_index];
+            if (b == 0) {
+                buf->consecutive_zeroes++;
+            } else if (b == 0x03 && buf->consecutive_zeroes == 2) {
+                if (++byte_index >= buf->data_size) {
+                    return false;
+                }
+                buf->offset += 8;
+                buf->consecutive_zeroes = buf->data[byte_index] == 0;
+            } else {
+                buf->consecutive_zeroes = 0;
+            }
+        }
+        uint32_t cur_offset = buf->offset + i;
+        uint32_t byte_index = cur_offset / 8;
+        if (byte_index >= buf->data_size) {
+            return false;
+        }
+        uint8_t bit_offset = 7 - cur_offset % 8;
+        result |= (buf->data[byte_index] >> bit_offset & 0x1) << (size - i - 1);
+    }
+    buf->offset += size;
+    *value = result;
+    return true;
+}
+
+static bool legacy_read_ueg(legacy_bitstream_t *buf, uint32_t *value) {
+    uint32_t bitcount = 0;
+    uint32_t tmp;
+    for (;;) {
+        if (!legacy_read_bits(buf, 1, &tmp)) return false;
+        if (tmp == 0) {
+            bitcount++;
+        } else {
+            break;
+        }
+    }
+    uint32_t result = 0;
+    if (bitcount) {
+        if (!legacy_read_bits(buf, bitcount, &tmp)) {
+            return false;
+        }
+        result = (uint32_t) ((1 << bitcount) - 1 + tmp);
+    }
+    *value = result;
+    return true;
+}
+
+#define NUM_VALUES 256
+
+typedef struct writer_t {
+    unsigned char *data;
+    size_t size;
+    uint32_t bit;
+    int zeroes;
+} writer_t;
+
+static void write_byte(writer_t *w, unsigned char b) {
+    if (w->zeroes >= 2 && b <= 3) {
+        w->data[w->size++] = 0x03;
+        w->zeroes = 0;
+    }
+    w->data[w->size++] = b;
+    w->zeroes = b == 0 ? w->zeroes + 1 : 0;
+}
+
+static void write_bit(writer_t *w, uint32_t bit, unsigned char *pending) {
+    *pending |= bit << (7 - w->bit);
+    if (++w->bit == 8) {
+        write_byte(w, *pending);
+        *pending = 0;
+        w->bit = 0;
+    }
+}
+
+/**
+ * Generate Exp-Golomb coded values, with emulation prevention bytes inserted
+ */
+static size_t generate(unsigned char *out, uint32_t *values) {
+    writer_t w = {.data = out};
+    unsigned char pending = 0;
+    for (int i = 0; i < NUM_VALUES; i++) {
+        // Mostly small values, like in parameter sets, and some zero runs to trigger emulation prevention
+        uint32_t value = i % 16 == 0 ? 0 : (uint32_t) rand() % (i % 3 == 0 ? 4096 : 16);
+        values[i] = value;
+        uint32_t code = value + 1;
+        int len = 0;
+        while ((code >> len) > 1) len++;
+        for (int j = 0; j < len; j++) write_bit(&w, 0, &pending);
+        for (int j = len; j >= 0; j--) write_bit(&w, code >> j & 1, &pending);
+    }
+    // rbsp_stop_one_bit
+    write_bit(&w, 1, &pending);
+    while (w.bit != 0) write_bit(&w, 0, &pending);
+    return w.size;
+}
+
+static double elapsed_ms(clock_t begin) {
+    return (double) (clock() - begin) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    unsigned char data[NUM_VALUES * 8];
+    uint32_t values[NUM_VALUES];
+    srand(42);
+    size_t size = generate(data, values);
+    assert(size <= BITSTREAM_MAX_SIZE);
+
+    uint32_t value;
+    volatile uint32_t sink = 0;
+
+    clock_t begin = clock();
+    for (int n = 0; n < iterations; n++) {
+        legacy_bitstream_t legacy;
+        legacy_init(&legacy, data, size);
+        for (int i = 0; i < NUM_VALUES; i++) {
+            if (!legacy_read_ueg(&legacy, &value) || value != values[i]) {
+                fprintf(stderr, "legacy: value #%d mismatch\n", i);
+                return 1;
+            }
+            sink += value;
+        }
+    }
+    double legacy_ms = elapsed_ms(begin);
+
+    begin = clock();
+    for (int n = 0; n < iterations; n++) {
+        bitstream_t buf;
+        bitstream_init(&buf, data, size);
+        for (int i = 0; i < NUM_VALUES; i++) {
+            if (!bitstream_read_ueg(&buf, &value) || value != values[i]) {
+                fprintf(stderr, "current: value #%d mismatch\n", i);
+                return 1;
+            }
+            sink += value;
+        }
+    }
+    double current_ms = elapsed_ms(begin);
+
+    double mbytes = (double) size * iterations / 1048576.0;
+    printf("%d iterations of %zu bytes\n", iterations, size);
+    printf("legacy:  %8.2f ms, %8.2f MB/s\n", legacy_ms, legacy_ms > 0 ? mbytes * 1000.0 / legacy_ms : 0);
+    printf("current: %8.2f ms, %8.2f MB/s\n", current_ms, current_ms > 0 ? mbytes * 1000.0 / current_ms : 0);
+    (void) sink;
+    return 0;
+}
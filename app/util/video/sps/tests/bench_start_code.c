@@ -0,0 +1,74 @@
+/**
+ * Compares start code scanner implementations over large synthetic access units.
+ * Usage: bench_start_code [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "start_code.h"
+
+#define AU_SIZE (512 * 1024)
+#define NUM_NALS 8
+
+/**
+ * Slice data without start code, but with zero bytes here and there, like real entropy coded data
+ */
+static void generate(unsigned char *data) {
+    srand(42);
+    for (size_t i = 0; i < AU_SIZE; i++) {
+        unsigned char b = (unsigned char) rand();
+        data[i] = b < 8 ? 0 : b;
+    }
+    for (size_t i = 2; i < AU_SIZE; i++) {
+        // Emulation prevention
+        if (data[i - 2] == 0 && data[i - 1] == 0 && data[i] <= 3) {
+            data[i] = 3;
+        }
+    }
+    for (int i = 0; i < NUM_NALS; i++) {
+        size_t pos = (size_t) i * (AU_SIZE / NUM_NALS);
+        data[pos] = 0;
+        data[pos + 1] = 0;
+        data[pos + 2] = 0;
+        data[pos + 3] = 1;
+    }
+}
+
+static int count_nals(start_code_find_fn find, const unsigned char *data) {
+    int count = 0;
+    int next = 0;
+    while ((next = find(data, AU_SIZE, next)) >= 0) {
+        count++;
+    }
+    return count;
+}
+
+static double run(start_code_find_fn find, const unsigned char *data, int iterations, int *count) {
+    clock_t begin = clock();
+    for (int n = 0; n < iterations; n++) {
+        *count = count_nals(find, data);
+    }
+    return (double) (clock() - begin) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100;
+    unsigned char *data = malloc(AU_SIZE);
+    generate(data);
+
+    int scalar_count, impl_count;
+    double scalar_ms = run(start_code_find_scalar, data, iterations, &scalar_count);
+    double impl_ms = run(start_code_find_impl(), data, iterations, &impl_count);
+    free(data);
+    if (scalar_count != NUM_NALS || impl_count != NUM_NALS) {
+        fprintf(stderr, "Expected %d NAL units, got %d (scalar) and %d (dispatched)\n", NUM_NALS, scalar_count,
+                impl_count);
+        return 1;
+    }
+    double mbytes = (double) AU_SIZE * iterations / 1048576.0;
+    printf("%d iterations of %d bytes\n", iterations, AU_SIZE);
+    printf("scalar:     %8.2f ms, %8.2f MB/s\n", scalar_ms, scalar_ms > 0 ? mbytes * 1000.0 / scalar_ms : 0);
+    printf("dispatched: %8.2f ms, %8.2f MB/s\n", impl_ms, impl_ms > 0 ? mbytes * 1000.0 / impl_ms : 0);
+    return 0;
+}
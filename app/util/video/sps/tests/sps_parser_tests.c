@@ -34,9 +34,67 @@ void test_sps_parse_dimension_hevc(void) {
     assert(dimension.height == 1080);
 }
 
+void test_sps_find_sps(void) {
+    static const unsigned char access_unit[] = {
+            0x00, 0x00, 0x00, 0x01, 0x09, 0xf0,
+            0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x2a,
+            0x00, 0x00, 0x00, 0x01, 0x68, 0xee,
+    };
+    const unsigned char *nal = NULL;
+    assert(sps_util_find_sps_h264(access_unit, sizeof(access_unit), &nal) == 4);
+    assert(nal == access_unit + 9);
+    assert(sps_util_find_sps_hevc(access_unit, sizeof(access_unit), &nal) == 0);
+
+    assert(sps_util_find_sps_hevc(h265_test_data, sizeof(h265_test_data), &nal) == sizeof(h265_test_data) - 4);
+    assert(nal == h265_test_data + 4);
+}
+
+void test_sps_parse_sps_dimension(void) {
+    sps_dimension_t dimension;
+    assert(sps_util_parse_sps_dimension_h264(h264_test_data + 4, sizeof(h264_test_data) - 4, &dimension));
+    assert(dimension.width == 1920);
+    assert(dimension.height == 1080);
+    assert(sps_util_parse_sps_dimension_hevc(h265_test_data + 4, sizeof(h265_test_data) - 4, &dimension));
+    assert(dimension.width == 1920);
+    assert(dimension.height == 1080);
+}
+
+void test_sps_parse_sps_info(void) {
+    sps_info_t info;
+    assert(sps_util_parse_sps_info_h264(h264_test_data + 4, sizeof(h264_test_data) - 4, &info));
+    assert(info.dimension.width == 1920);
+    assert(info.dimension.height == 1080);
+    assert(info.profile_idc == 100);
+    assert(info.level_idc == 42);
+    assert(info.chroma_format_idc == 1);
+    assert(info.bit_depth_luma == 8);
+    assert(info.bit_depth_chroma == 8);
+    assert(!info.video_full_range_flag);
+    assert(info.colour_primaries == 6);
+    assert(info.transfer_characteristics == 6);
+    assert(info.matrix_coefficients == 6);
+    assert(info.num_units_in_tick == 1000);
+    assert(info.time_scale == 120000);
+
+    assert(sps_util_parse_sps_info_hevc(h265_test_data + 4, sizeof(h265_test_data) - 4, &info));
+    assert(info.dimension.width == 1920);
+    assert(info.dimension.height == 1080);
+    assert(info.profile_idc == 1);
+    assert(info.level_idc == 123);
+    assert(info.chroma_format_idc == 1);
+    assert(info.bit_depth_luma == 8);
+    assert(info.bit_depth_chroma == 8);
+    assert(info.colour_primaries == 6);
+    assert(info.num_units_in_tick == 1);
+    assert(info.time_scale == 60);
+}
+
 // not needed when using generate_test_runner.rb
 int main() {
     test_sps_parse_dimension_h264();
     test_sps_parse_dimension_hevc();
+    test_sps_find_sps();
+    test_sps_parse_sps_dimension();
+    test_sps_parse_sps_info();
     return 0;
 }
\ No newline at end of file
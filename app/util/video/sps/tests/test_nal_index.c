@@ -0,0 +1,41 @@
+#include <assert.h>
+#include "sps_util.h"
+
+int main() {
+    static const unsigned char h264_au[] = {
+            0x00, 0x00, 0x00, 0x01, 0x09, 0xf0,
+            0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x2a,
+            0x00, 0x00, 0x00, 0x01, 0x68, 0xee, 0x00,
+            0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x00, 0x03, 0x00, 0x21,
+    };
+    sps_nal_index_t index;
+    assert(sps_util_nal_index_h264(h264_au, sizeof(h264_au), &index) == 4);
+    assert(!index.truncated);
+    assert(index.units[0].type == 9 && index.units[0].offset == 4 && index.units[0].size == 2);
+    assert(index.units[1].type == 7 && index.units[1].offset == 9 && index.units[1].size == 4);
+    assert(index.units[2].type == 8 && index.units[2].offset == 17 && index.units[2].size == 2);
+    assert(index.units[3].type == 5 && index.units[3].offset == 23 && index.units[3].size == 8);
+    assert(sps_util_nal_index_find(&index, SPS_UTIL_NAL_TYPE_SPS_H264) == &index.units[1]);
+    assert(sps_util_nal_index_find(&index, 6) == NULL);
+
+    static const unsigned char hevc_au[] = {
+            0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c,
+            0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01,
+            0x00, 0x00, 0x01, 0x02, 0x03, 0xaf,
+    };
+    assert(sps_util_nal_index_hevc(hevc_au, sizeof(hevc_au), &index) == 3);
+    assert(index.units[0].type == 32 && index.units[0].temporal_id == 0 && index.units[0].layer_id == 0);
+    assert(index.units[1].type == SPS_UTIL_NAL_TYPE_SPS_HEVC && index.units[1].offset == 11);
+    assert(index.units[2].type == 1 && index.units[2].temporal_id == 2 && index.units[2].size == 3);
+
+    unsigned char many[4 * (SPS_UTIL_NAL_INDEX_MAX + 1)];
+    for (int i = 0; i < SPS_UTIL_NAL_INDEX_MAX + 1; i++) {
+        many[i * 4] = 0x00;
+        many[i * 4 + 1] = 0x00;
+        many[i * 4 + 2] = 0x01;
+        many[i * 4 + 3] = 0x41;
+    }
+    assert(sps_util_nal_index_h264(many, sizeof(many), &index) == SPS_UTIL_NAL_INDEX_MAX);
+    assert(index.truncated);
+    return 0;
+}
@@ -1,14 +1,67 @@
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 #include "common.h"
+#include "start_code.h"
 
-int main() {
+static void test_cases(start_code_find_fn find) {
     unsigned char data1[] = {0x00, 0x00, 0x00, 0x01, 0x33};
-    assert(sps_util_nal_skip_start_code(data1, 5, 0) == 4);
+    assert(find(data1, 5, 0) == 4);
     unsigned char data2[] = {0x00, 0x00, 0x00, 0x02, 0x33};
-    assert(sps_util_nal_skip_start_code(data2, 5, 0) == -1);
+    assert(find(data2, 5, 0) == -1);
     unsigned char data3[] = {0x00, 0x00, 0x00, 0x00, 0x01, 0x33};
-    assert(sps_util_nal_skip_start_code(data3, 6, 0) == 5);
+    assert(find(data3, 6, 0) == 5);
     unsigned char data4[] = {0x00, 0x01};
-    assert(sps_util_nal_skip_start_code(data4, 2, 0) == -1);
+    assert(find(data4, 2, 0) == -1);
+}
+
+static void test_long_data(start_code_find_fn find) {
+    unsigned char data[100];
+    memset(data, 0x55, sizeof(data));
+    assert(find(data, sizeof(data), 0) == -1);
+    // Start code across 16 bytes boundary
+    for (int pos = 0; pos + 3 < (int) sizeof(data); pos++) {
+        memset(data, 0x55, sizeof(data));
+        data[pos] = 0x00;
+        data[pos + 1] = 0x00;
+        data[pos + 2] = 0x01;
+        assert(find(data, sizeof(data), 0) == pos + 3);
+        assert(find(data, sizeof(data), pos) == pos + 3);
+        // Zero bytes before begin don't count
+        assert(find(data, sizeof(data), pos + 1) == -1);
+    }
+    // Start code at the end, without payload
+    memset(data, 0x55, sizeof(data));
+    data[97] = 0x00;
+    data[98] = 0x00;
+    data[99] = 0x01;
+    assert(find(data, sizeof(data), 0) == -1);
+}
+
+static void test_random_data(start_code_find_fn find) {
+    unsigned char data[1000];
+    srand(42);
+    for (int n = 0; n < 200; n++) {
+        for (int i = 0; i < (int) sizeof(data); i++) {
+            // Make zeros common enough to form start codes
+            int r = rand() % 8;
+            data[i] = r < 3 ? 0 : r == 3 ? 1 : (unsigned char) rand();
+        }
+        size_t begin = (size_t) (rand() % 40);
+        assert(find(data, sizeof(data), begin) == start_code_find_scalar(data, sizeof(data), begin));
+        int next = (int) begin;
+        while ((next = find(data, sizeof(data), next)) >= 0) {
+            assert(data[next - 1] == 1 && data[next - 2] == 0 && data[next - 3] == 0);
+        }
+    }
+}
+
+int main() {
+    test_cases(sps_util_nal_skip_start_code);
+    test_cases(start_code_find_scalar);
+    test_cases(start_code_find_impl());
+    test_long_data(start_code_find_scalar);
+    test_long_data(start_code_find_impl());
+    test_random_data(start_code_find_impl());
     return 0;
-}
\ No newline at end of file
+}
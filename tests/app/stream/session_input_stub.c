@@ -0,0 +1,76 @@
+/**
+ * ihslib.h isn't included, so these can replace the real functions without the session library. Enum parameters are
+ * declared with their underlying type.
+ */
+#include "session_input_stub.h"
+
+#include <SDL.h>
+
+#define MAX_INPUTS 256
+
+typedef struct IHS_Session IHS_Session;
+
+static session_input_t inputs[MAX_INPUTS];
+static int num_inputs = 0;
+static SDL_SpinLock inputs_lock = 0;
+
+static void record(session_input_type_t type, int value, int value2) {
+    SDL_AtomicLock(&inputs_lock);
+    if (num_inputs < MAX_INPUTS) {
+        inputs[num_inputs++] = (session_input_t) {.type = type, .value = value, .value2 = value2};
+    }
+    SDL_AtomicUnlock(&inputs_lock);
+}
+
+void session_input_stub_reset() {
+    SDL_AtomicLock(&inputs_lock);
+    num_inputs = 0;
+    SDL_AtomicUnlock(&inputs_lock);
+}
+
+int session_input_stub_count() {
+    SDL_AtomicLock(&inputs_lock);
+    int count = num_inputs;
+    SDL_AtomicUnlock(&inputs_lock);
+    return count;
+}
+
+bool session_input_stub_get(int index, session_input_t *input) {
+    SDL_AtomicLock(&inputs_lock);
+    bool found = index < num_inputs;
+    if (found) {
+        *input = inputs[index];
+    }
+    SDL_AtomicUnlock(&inputs_lock);
+    return found;
+}
+
+void IHS_SessionSendKeyDown(IHS_Session *session, int scancode) {
+    (void) session;
+    record(SESSION_INPUT_KEY_DOWN, scancode, 0);
+}
+
+void IHS_SessionSendKeyUp(IHS_Session *session, int scancode) {
+    (void) session;
+    record(SESSION_INPUT_KEY_UP, scancode, 0);
+}
+
+void IHS_SessionSendMouseMovement(IHS_Session *session, int dx, int dy) {
+    (void) session;
+    record(SESSION_INPUT_MOUSE_MOVEMENT, dx, dy);
+}
+
+void IHS_SessionSendMouseDown(IHS_Session *session, int button) {
+    (void) session;
+    record(SESSION_INPUT_MOUSE_DOWN, button, 0);
+}
+
+void IHS_SessionSendMouseUp(IHS_Session *session, int button) {
+    (void) session;
+    record(SESSION_INPUT_MOUSE_UP, button, 0);
+}
+
+void IHS_SessionSendMouseWheel(IHS_Session *session, int direction) {
+    (void) session;
+    record(SESSION_INPUT_MOUSE_WHEEL, direction, 0);
+}
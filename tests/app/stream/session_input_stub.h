@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * Stands in for ihslib session input functions, and records what would have been sent to host.
+ */
+typedef enum session_input_type_t {
+    SESSION_INPUT_KEY_DOWN,
+    SESSION_INPUT_KEY_UP,
+    SESSION_INPUT_MOUSE_MOVEMENT,
+    SESSION_INPUT_MOUSE_DOWN,
+    SESSION_INPUT_MOUSE_UP,
+    SESSION_INPUT_MOUSE_WHEEL,
+} session_input_type_t;
+
+typedef struct session_input_t {
+    session_input_type_t type;
+    /** Scancode, button, wheel direction, or horizontal movement */
+    int value;
+    /** Vertical movement */
+    int value2;
+} session_input_t;
+
+void session_input_stub_reset();
+
+int session_input_stub_count();
+
+bool session_input_stub_get(int index, session_input_t *input);
@@ -0,0 +1,85 @@
+/**
+ * Compresses frames of various sizes, up to 120ms Opus frames plus one resampled sample, and checks output stays within
+ * the input ramp. Also checks lateness reported for gap detection matches what arrival updates use.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "backend/stream/audio_jitter.h"
+
+#define CHANNELS 2
+
+static int check_compress(int samples, bool is_float) {
+    void *pcm = calloc((size_t) samples * CHANNELS, is_float ? sizeof(float) : sizeof(int16_t));
+    // Ramp, so interpolated samples must stay monotonic and within range
+    for (int i = 0; i < samples * CHANNELS; i++) {
+        int value = i / CHANNELS * 30000 / samples;
+        if (is_float) {
+            ((float *) pcm)[i] = (float) value;
+        } else {
+            ((int16_t *) pcm)[i] = (int16_t) value;
+        }
+    }
+    int out_samples = audio_jitter_compress(pcm, CHANNELS, samples, is_float);
+    int failures = 0;
+    if (out_samples != samples - samples / 4) {
+        fprintf(stderr, "%d samples: expected %d out, got %d\n", samples, samples - samples / 4, out_samples);
+        failures++;
+    }
+    int last = -1, max = (samples - 1) * 30000 / samples;
+    for (int i = 0; i < out_samples * CHANNELS && failures == 0; i++) {
+        int value = is_float ? (int) ((float *) pcm)[i] : ((int16_t *) pcm)[i];
+        if (value < last || value > max) {
+            fprintf(stderr, "%d samples (%s): sample #%d out of range: %d\n", samples, is_float ? "float" : "s16",
+                    i, value);
+            failures++;
+        }
+        last = value;
+    }
+    free(pcm);
+    return failures;
+}
+
+static int check_lateness() {
+    audio_jitter_t jitter;
+    audio_jitter_init(&jitter, 48000, 10, 200);
+    audio_jitter_arrived(&jitter, 1000000, 0);
+    int failures = 0;
+    // Early arrival isn't late, and moves the clock to it
+    if (audio_jitter_lateness(&jitter, 1015000, 20000) != 0) {
+        fprintf(stderr, "early packet counted as late\n");
+        failures++;
+    }
+    audio_jitter_arrived(&jitter, 1015000, 20000);
+    // 60ms gap after a 20ms frame
+    int64_t late = audio_jitter_lateness(&jitter, 1095000, 20000);
+    if (late != 60000) {
+        fprintf(stderr, "expected 60000us late, got %d\n", (int) late);
+        failures++;
+    }
+    // With concealed frames fed, the packet is on time
+    if (audio_jitter_lateness(&jitter, 1095000, 80000) != 0) {
+        fprintf(stderr, "concealed frames not counted as arrived\n");
+        failures++;
+    }
+    audio_jitter_arrived(&jitter, 1095000, 80000);
+    if (jitter.expected_us != 1095000 || jitter.jitter_us != 0) {
+        fprintf(stderr, "unexpected clock after concealment: expected=%d, jitter=%d\n", (int) jitter.expected_us,
+                (int) jitter.jitter_us);
+        failures++;
+    }
+    return failures;
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+    static const int sizes[] = {120, 480, 960, 2880, 5760, 5761};
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        failures += check_compress(sizes[i], false);
+        failures += check_compress(sizes[i], true);
+    }
+    failures += check_lateness();
+    return failures == 0 ? 0 : 1;
+}
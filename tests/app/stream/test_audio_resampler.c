@@ -0,0 +1,123 @@
+/**
+ * Simulates a sink consuming samples at its own clock while the host sends them at a constant ppm offset, and checks
+ * the drift controller settles on that offset, keeping the backlog bounded. Also checks output length for fixed
+ * corrections, interpolation staying within input, and correction being clamped.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+
+#include "backend/stream/audio_resampler.h"
+#include "test_expect.h"
+
+#define SAMPLE_RATE 48000
+#define FRAME_SAMPLES 480
+#define CHANNELS 2
+#define SIMULATED_SECONDS 300
+
+/**
+ * @param resampler Initialized here, and left with the correction it settled on
+ * @param drift_ppm How much faster host clock is than sink clock
+ * @param max_error_us Largest backlog error seen in the second half of simulation
+ * @return Correction after the simulation
+ */
+static int simulate_drift(audio_resampler_t *resampler, int drift_ppm, bool is_float, int64_t *max_error_us) {
+    audio_resampler_init(resampler, CHANNELS, is_float);
+    size_t unit = CHANNELS * (is_float ? sizeof(float) : sizeof(int16_t));
+    void *in = calloc(FRAME_SAMPLES + 1, unit);
+    void *out = calloc(FRAME_SAMPLES + 2, unit);
+    // Samples in sink beyond target, and fraction of a sample host has produced but not sent yet
+    double backlog = 0, host_remainder = 0;
+    *max_error_us = 0;
+    int frames = SIMULATED_SECONDS * SAMPLE_RATE / FRAME_SAMPLES;
+    for (int frame = 1; frame <= frames; frame++) {
+        host_remainder += FRAME_SAMPLES * (1 + drift_ppm / 1e6);
+        int in_samples = (int) host_remainder;
+        host_remainder -= in_samples;
+        backlog += audio_resampler_process(resampler, in, in_samples, out) - FRAME_SAMPLES;
+
+        Uint64 now_us = (Uint64) frame * FRAME_SAMPLES * 1000000 / SAMPLE_RATE;
+        int64_t error_us = (int64_t) (backlog * 1000000 / SAMPLE_RATE);
+        audio_resampler_update(resampler, now_us, error_us);
+        if (frame > frames / 2 && SDL_abs((int) error_us) > *max_error_us) {
+            *max_error_us = SDL_abs((int) error_us);
+        }
+    }
+    free(in);
+    free(out);
+    return resampler->ppm;
+}
+
+static void check_convergence(int drift_ppm, bool is_float) {
+    audio_resampler_t resampler;
+    int64_t max_error_us;
+    int ppm = simulate_drift(&resampler, drift_ppm, is_float, &max_error_us);
+    EXPECT(SDL_abs(ppm - drift_ppm) <= 5, "drift %dppm (%s): settled at %dppm", drift_ppm, is_float ? "float" : "s16",
+           ppm);
+    EXPECT(max_error_us < 5000, "drift %dppm (%s): backlog error up to %dus after settling", drift_ppm,
+           is_float ? "float" : "s16", (int) max_error_us);
+}
+
+static void check_clamped(int drift_ppm) {
+    audio_resampler_t resampler;
+    int64_t max_error_us;
+    int ppm = simulate_drift(&resampler, drift_ppm, false, &max_error_us);
+    int expected = drift_ppm > 0 ? AUDIO_RESAMPLER_MAX_PPM : -AUDIO_RESAMPLER_MAX_PPM;
+    EXPECT(ppm == expected, "drift %dppm: expected correction clamped to %dppm, got %dppm", drift_ppm, expected, ppm);
+}
+
+/**
+ * Feeds a ramp with the correction settled for a drift, and checks each frame gives one sample more or less at most,
+ * total length follows the step, and output stays monotonic within input range.
+ */
+static void check_output(int drift_ppm) {
+    audio_resampler_t resampler;
+    int64_t max_error_us;
+    simulate_drift(&resampler, drift_ppm, false, &max_error_us);
+    int ppm = resampler.ppm;
+
+    int16_t in[FRAME_SAMPLES * CHANNELS], out[(FRAME_SAMPLES + 1) * CHANNELS];
+    int64_t total_in = 0, total_out = 0;
+    int last = 0;
+    for (int frame = 0; frame < 1000; frame++) {
+        for (int i = 0; i < FRAME_SAMPLES; i++) {
+            // Slow ramp over the whole run, so interpolation across frame boundary can be checked too
+            int16_t value = (int16_t) ((total_in + i) / 16);
+            for (int ch = 0; ch < CHANNELS; ch++) {
+                in[i * CHANNELS + ch] = value;
+            }
+        }
+        int out_samples = audio_resampler_process(&resampler, in, FRAME_SAMPLES, out);
+        EXPECT(SDL_abs(out_samples - FRAME_SAMPLES) <= 1, "output %dppm: frame #%d gave %d samples", ppm, frame,
+               out_samples);
+        for (int i = 0; i < out_samples * CHANNELS; i++) {
+            if (out[i] < last || out[i] > in[(FRAME_SAMPLES - 1) * CHANNELS]) {
+                EXPECT(false, "output %dppm: frame #%d sample #%d out of range: %d", ppm, frame, i, out[i]);
+                break;
+            }
+            last = out[i];
+        }
+        total_in += FRAME_SAMPLES;
+        total_out += out_samples;
+    }
+    double expected = (double) total_in * (double) ((uint64_t) 1 << 32) / (double) resampler.step;
+    EXPECT(SDL_fabs(total_out - expected) <= 1, "output %dppm: expected %.1f samples, got %d", ppm, expected,
+           (int) total_out);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+    check_output(0);
+    check_output(300);
+    check_output(-2000);
+
+    check_convergence(0, false);
+    check_convergence(150, false);
+    check_convergence(-400, false);
+    check_convergence(250, true);
+    check_clamped(2000);
+    check_clamped(-2000);
+    return failures == 0 ? 0 : 1;
+}
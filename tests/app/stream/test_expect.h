@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdio.h>
+
+/**
+ * Failed expectations are printed and counted, so a test reports all of them in one run. Return value of the test
+ * should be based on failures.
+ */
+static int failures = 0;
+
+#define EXPECT(cond, ...) do {        \
+    if (!(cond)) {                    \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr);          \
+        failures++;                   \
+    }                                 \
+} while (0)
@@ -0,0 +1,111 @@
+/**
+ * Feeds axis and button events through the HID report limiter with a fake clock, and checks axis motion is coalesced
+ * to one report per controller per interval, while buttons are sent immediately and in order.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "backend/stream/hid_report_limiter.h"
+#include "test_expect.h"
+
+#define MAX_SENT 256
+
+typedef struct recorder_t {
+    SDL_Event events[MAX_SENT];
+    int count;
+} recorder_t;
+
+static void record(const SDL_Event *event, void *context) {
+    recorder_t *recorder = context;
+    if (recorder->count < MAX_SENT) {
+        recorder->events[recorder->count++] = *event;
+    }
+}
+
+static SDL_Event axis_event(SDL_JoystickID which, Uint8 axis, Sint16 value, Uint32 timestamp) {
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.caxis.type = SDL_CONTROLLERAXISMOTION;
+    event.caxis.timestamp = timestamp;
+    event.caxis.which = which;
+    event.caxis.axis = axis;
+    event.caxis.value = value;
+    return event;
+}
+
+static SDL_Event button_event(SDL_JoystickID which, Uint8 button, Uint32 timestamp) {
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.cbutton.type = SDL_CONTROLLERBUTTONDOWN;
+    event.cbutton.timestamp = timestamp;
+    event.cbutton.which = which;
+    event.cbutton.button = button;
+    event.cbutton.state = SDL_PRESSED;
+    return event;
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+    recorder_t recorder = {.count = 0};
+    hid_report_limiter_t limiter;
+    // 250Hz, one report every 4ms
+    hid_report_limiter_init(&limiter, 250, record, &recorder);
+    Uint32 now = 1000;
+
+    // First motion goes out immediately
+    SDL_Event event = axis_event(0, SDL_CONTROLLER_AXIS_LEFTX, 100, now);
+    hid_report_limiter_handle_event(&limiter, &event, now);
+    EXPECT(recorder.count == 1, "first motion: expected 1 sent, got %d", recorder.count);
+
+    // Motion within interval is merged into latest value
+    for (int i = 1; i <= 3; i++) {
+        event = axis_event(0, SDL_CONTROLLER_AXIS_LEFTX, (Sint16) (100 + i), now + i);
+        hid_report_limiter_handle_event(&limiter, &event, now + i);
+        event = axis_event(0, SDL_CONTROLLER_AXIS_LEFTY, (Sint16) (-100 - i), now + i);
+        hid_report_limiter_handle_event(&limiter, &event, now + i);
+    }
+    EXPECT(recorder.count == 1, "coalesced motion: expected 1 sent, got %d", recorder.count);
+    Uint32 delay = hid_report_limiter_flush(&limiter, now + 3);
+    EXPECT(delay == 1, "flush before due: expected 1ms delay, got %u", delay);
+    EXPECT(recorder.count == 1, "flush before due: expected 1 sent, got %d", recorder.count);
+
+    delay = hid_report_limiter_flush(&limiter, now + 4);
+    EXPECT(delay == UINT32_MAX, "flush when due: expected nothing pending, got %u", delay);
+    // Both axes moved, but the controller gets a single report
+    EXPECT(recorder.count == 2, "flush when due: expected 2 sent, got %d", recorder.count);
+    EXPECT(recorder.events[1].caxis.axis == SDL_CONTROLLER_AXIS_LEFTY && recorder.events[1].caxis.value == -103,
+           "report: expected latest moved axis LEFTY=-103, got %d=%d", recorder.events[1].caxis.axis,
+           recorder.events[1].caxis.value);
+    EXPECT(recorder.events[1].caxis.timestamp == now + 1, "timestamp: expected oldest coalesced event");
+
+    // Button flushes pending motion of the same controller first, and isn't held back
+    now += 5;
+    event = axis_event(0, SDL_CONTROLLER_AXIS_RIGHTX, 500, now);
+    hid_report_limiter_handle_event(&limiter, &event, now);
+    event = button_event(0, SDL_CONTROLLER_BUTTON_A, now);
+    hid_report_limiter_handle_event(&limiter, &event, now);
+    EXPECT(recorder.count == 4, "button: expected 4 sent, got %d", recorder.count);
+    EXPECT(recorder.events[2].type == SDL_CONTROLLERAXISMOTION && recorder.events[3].type == SDL_CONTROLLERBUTTONDOWN,
+           "button: pending motion should be sent before button");
+
+    // Controllers are limited separately
+    event = axis_event(1, SDL_CONTROLLER_AXIS_TRIGGERLEFT, 32767, now);
+    hid_report_limiter_handle_event(&limiter, &event, now);
+    EXPECT(recorder.count == 5, "second controller: expected 5 sent, got %d", recorder.count);
+
+    printf("received %u axis events, sent %u reports\n", limiter.received, limiter.sent);
+    EXPECT(limiter.received == 9 && limiter.sent == 4, "stats: expected 9 received 4 reports sent");
+
+    // Unlimited rate passes everything through
+    hid_report_limiter_init(&limiter, 0, record, &recorder);
+    recorder.count = 0;
+    for (int i = 0; i < 10; i++) {
+        event = axis_event(0, SDL_CONTROLLER_AXIS_LEFTX, (Sint16) i, now);
+        hid_report_limiter_handle_event(&limiter, &event, now);
+    }
+    EXPECT(recorder.count == 10, "unlimited: expected 10 sent, got %d", recorder.count);
+    return failures == 0 ? 0 : 1;
+}
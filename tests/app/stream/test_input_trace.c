@@ -0,0 +1,74 @@
+/**
+ * Records input latency from several threads at once, and checks nothing is lost and percentiles land in the right
+ * buckets.
+ * Usage: test_input_trace [samples per thread]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+
+#include "backend/stream/input_trace.h"
+
+#define NUM_THREADS 4
+
+typedef struct recorder_t {
+    input_trace_t *trace;
+    int samples;
+} recorder_t;
+
+static int record_thread(void *arg) {
+    recorder_t *recorder = arg;
+    for (int i = 0; i < recorder->samples; i++) {
+        // 1 in 100 samples is slow
+        input_trace_record_us(recorder->trace, INPUT_TRACE_MOUSE_MOTION, i % 100 == 99 ? 50000 : 1500);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int samples = argc > 1 ? atoi(argv[1]) : 100000;
+    input_trace_t *trace = input_trace_create();
+    recorder_t recorder = {.trace = trace, .samples = samples};
+    SDL_Thread *threads[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        threads[i] = SDL_CreateThread(record_thread, "recorder", &recorder);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    int failures = 0;
+    input_trace_summary_t summary;
+    input_trace_get_summary(trace, INPUT_TRACE_MOUSE_MOTION, &summary);
+    if (summary.count != (uint32_t) samples * NUM_THREADS) {
+        fprintf(stderr, "count: expected %d, got %u\n", samples * NUM_THREADS, summary.count);
+        failures++;
+    }
+    if (summary.p50_us != 2048) {
+        fprintf(stderr, "p50: expected 2048, got %u\n", summary.p50_us);
+        failures++;
+    }
+    if (summary.max_us != 50000) {
+        fprintf(stderr, "max: expected 50000, got %u\n", summary.max_us);
+        failures++;
+    }
+    input_trace_get_summary(trace, INPUT_TRACE_KEYBOARD, &summary);
+    if (summary.count != 0) {
+        fprintf(stderr, "keyboard: expected no samples, got %u\n", summary.count);
+        failures++;
+    }
+
+    char text[256];
+    input_trace_format(trace, text, sizeof(text));
+    printf("%s\n", text);
+
+    input_trace_reset(trace);
+    input_trace_get_summary(trace, INPUT_TRACE_MOUSE_MOTION, &summary);
+    if (summary.count != 0 || summary.max_us != 0) {
+        fprintf(stderr, "reset: histogram not cleared\n");
+        failures++;
+    }
+    input_trace_destroy(trace);
+    return failures == 0 ? 0 : 1;
+}
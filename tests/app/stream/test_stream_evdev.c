@@ -0,0 +1,254 @@
+/**
+ * Creates a virtual mouse and keyboard with uinput, and checks what evdev input forwards, and in which order. Skipped
+ * when uinput isn't available, or the created devices can't be read.
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+
+#include <SDL.h>
+
+#include "backend/stream/stream_evdev.h"
+#include "session_input_stub.h"
+#include "test_expect.h"
+
+#define SKIP_RETURN_CODE 127
+#define WAIT_TIMEOUT_MS 2000
+
+static int create_device(const char *name, bool keyboard) {
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    if (keyboard) {
+        static const int keys[] = {KEY_ESC, KEY_A, KEY_B, KEY_SPACE, KEY_ENTER};
+        for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+            ioctl(fd, UI_SET_KEYBIT, keys[i]);
+        }
+    } else {
+        ioctl(fd, UI_SET_KEYBIT, BTN_LEFT);
+        ioctl(fd, UI_SET_KEYBIT, BTN_RIGHT);
+        ioctl(fd, UI_SET_EVBIT, EV_REL);
+        ioctl(fd, UI_SET_RELBIT, REL_X);
+        ioctl(fd, UI_SET_RELBIT, REL_Y);
+        ioctl(fd, UI_SET_RELBIT, REL_WHEEL);
+    }
+    struct uinput_user_dev dev;
+    memset(&dev, 0, sizeof(dev));
+    snprintf(dev.name, UINPUT_MAX_NAME_SIZE, "%s", name);
+    dev.id.bustype = BUS_VIRTUAL;
+    dev.id.vendor = 0x1234;
+    dev.id.product = keyboard ? 1 : 2;
+    if (write(fd, &dev, sizeof(dev)) != sizeof(dev) || ioctl(fd, UI_DEV_CREATE) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void destroy_device(int fd) {
+    ioctl(fd, UI_DEV_DESTROY);
+    close(fd);
+}
+
+/**
+ * Waits for the event node of the device to show up, and checks it can be opened like evdev input would.
+ */
+static bool device_readable(int fd) {
+#ifdef UI_GET_SYSNAME
+    char sysname[64];
+    if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0) {
+        return false;
+    }
+    char path[300];
+    snprintf(path, sizeof(path), "/sys/devices/virtual/input/%s", sysname);
+    for (int elapsed = 0; elapsed < WAIT_TIMEOUT_MS; elapsed += 10) {
+        DIR *dir = opendir(path);
+        struct dirent *entry;
+        while (dir != NULL && (entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "event", 5) != 0) {
+                continue;
+            }
+            char node[300];
+            snprintf(node, sizeof(node), "/dev/input/%s", entry->d_name);
+            int node_fd = open(node, O_RDONLY | O_NONBLOCK);
+            if (node_fd >= 0 || errno != ENOENT) {
+                closedir(dir);
+                if (node_fd < 0) {
+                    return false;
+                }
+                close(node_fd);
+                return true;
+            }
+        }
+        if (dir != NULL) {
+            closedir(dir);
+        }
+        SDL_Delay(10);
+    }
+    return false;
+#else
+    (void) fd;
+    SDL_Delay(200);
+    return true;
+#endif
+}
+
+static void emit(int fd, unsigned short type, unsigned short code, int value) {
+    struct input_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    if (write(fd, &event, sizeof(event)) != sizeof(event)) {
+        fprintf(stderr, "Failed to emit event: %s\n", strerror(errno));
+        failures++;
+    }
+}
+
+static void emit_key(int fd, unsigned short code, int value) {
+    emit(fd, EV_KEY, code, value);
+    emit(fd, EV_SYN, SYN_REPORT, 0);
+}
+
+static bool wait_for_inputs(int count) {
+    for (int elapsed = 0; elapsed < WAIT_TIMEOUT_MS; elapsed += 5) {
+        if (session_input_stub_count() >= count) {
+            return true;
+        }
+        SDL_Delay(5);
+    }
+    return false;
+}
+
+static void expect_input(int index, session_input_type_t type, int value, int value2, const char *what) {
+    session_input_t input;
+    if (!session_input_stub_get(index, &input)) {
+        fprintf(stderr, "%s: nothing sent\n", what);
+        failures++;
+        return;
+    }
+    EXPECT(input.type == type && input.value == value && input.value2 == value2,
+           "%s: expected type %d (%d, %d), got type %d (%d, %d)", what, type, value, value2, input.type, input.value,
+           input.value2);
+}
+
+static bool has_key_down(int scancode) {
+    session_input_t input;
+    for (int i = 0; session_input_stub_get(i, &input); i++) {
+        if (input.type == SESSION_INPUT_KEY_DOWN && input.value == scancode) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_relmouse(int keyboard, int mouse) {
+    session_input_stub_reset();
+    stream_evdev_t *evdev = stream_evdev_start(NULL, true, NULL);
+    EXPECT(evdev != NULL, "relmouse: failed to start");
+    if (evdev == NULL) {
+        return;
+    }
+
+    // Motion is summed up until SYN_REPORT, and sent before the click following it
+    emit(mouse, EV_REL, REL_X, 3);
+    emit(mouse, EV_REL, REL_X, 2);
+    emit(mouse, EV_REL, REL_Y, -3);
+    emit(mouse, EV_SYN, SYN_REPORT, 0);
+    emit(mouse, EV_REL, REL_X, 2);
+    emit(mouse, EV_SYN, SYN_REPORT, 0);
+    emit_key(mouse, BTN_LEFT, 1);
+    emit_key(mouse, BTN_LEFT, 0);
+    emit(mouse, EV_REL, REL_WHEEL, 1);
+    emit(mouse, EV_SYN, SYN_REPORT, 0);
+    EXPECT(wait_for_inputs(5), "relmouse: expected 5 mouse inputs, got %d", session_input_stub_count());
+    expect_input(0, SESSION_INPUT_MOUSE_MOVEMENT, 5, -3, "first motion");
+    expect_input(1, SESSION_INPUT_MOUSE_MOVEMENT, 2, 0, "second motion");
+    expect_input(2, SESSION_INPUT_MOUSE_DOWN, IHS_MOUSE_BUTTON_LEFT, 0, "button down");
+    expect_input(3, SESSION_INPUT_MOUSE_UP, IHS_MOUSE_BUTTON_LEFT, 0, "button up");
+    expect_input(4, SESSION_INPUT_MOUSE_WHEEL, IHS_MOUSE_WHEEL_UP, 0, "wheel");
+
+    // Escape is left to SDL for opening the overlay
+    emit_key(keyboard, KEY_ESC, 1);
+    emit_key(keyboard, KEY_ESC, 0);
+    emit_key(keyboard, KEY_A, 1);
+    emit_key(keyboard, KEY_A, 0);
+    EXPECT(wait_for_inputs(7), "keyboard: expected 7 inputs, got %d", session_input_stub_count());
+    expect_input(5, SESSION_INPUT_KEY_DOWN, SDL_SCANCODE_A, 0, "key down");
+    expect_input(6, SESSION_INPUT_KEY_UP, SDL_SCANCODE_A, 0, "key up");
+
+    // Keyboard plugged in after start is picked up
+    int hotplugged = create_device("ihsplay test hotplug keyboard", true);
+    EXPECT(hotplugged >= 0, "hotplug: failed to create keyboard");
+    if (hotplugged >= 0) {
+        for (int elapsed = 0; elapsed < WAIT_TIMEOUT_MS && !has_key_down(SDL_SCANCODE_B); elapsed += 50) {
+            emit_key(hotplugged, KEY_B, 1);
+            emit_key(hotplugged, KEY_B, 0);
+            SDL_Delay(50);
+        }
+        EXPECT(has_key_down(SDL_SCANCODE_B), "hotplug: key of new keyboard not sent");
+        destroy_device(hotplugged);
+    }
+    stream_evdev_stop(evdev);
+}
+
+static void test_absolute_mouse(int keyboard, int mouse) {
+    session_input_stub_reset();
+    stream_evdev_t *evdev = stream_evdev_start(NULL, false, NULL);
+    EXPECT(evdev != NULL, "absolute mouse: failed to start");
+    if (evdev == NULL) {
+        return;
+    }
+    EXPECT(!stream_evdev_reads_all_mice(evdev), "absolute mouse: mice should be left to SDL");
+
+    // Mouse is left to SDL entirely, so clicks can't overtake movement coalesced there
+    emit(mouse, EV_REL, REL_X, 5);
+    emit(mouse, EV_SYN, SYN_REPORT, 0);
+    emit_key(mouse, BTN_LEFT, 1);
+    emit_key(mouse, BTN_LEFT, 0);
+    emit_key(keyboard, KEY_A, 1);
+    emit_key(keyboard, KEY_A, 0);
+    EXPECT(wait_for_inputs(2), "absolute mouse: expected 2 key inputs, got %d", session_input_stub_count());
+    SDL_Delay(100);
+    EXPECT(session_input_stub_count() == 2, "absolute mouse: expected only keys, got %d inputs",
+           session_input_stub_count());
+    expect_input(0, SESSION_INPUT_KEY_DOWN, SDL_SCANCODE_A, 0, "absolute mouse: key down");
+    expect_input(1, SESSION_INPUT_KEY_UP, SDL_SCANCODE_A, 0, "absolute mouse: key up");
+    stream_evdev_stop(evdev);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+    int keyboard = create_device("ihsplay test keyboard", true);
+    int mouse = create_device("ihsplay test mouse", false);
+    if (keyboard < 0 || mouse < 0) {
+        fprintf(stderr, "uinput unavailable: %s\n", strerror(errno));
+        if (keyboard >= 0) {
+            destroy_device(keyboard);
+        }
+        if (mouse >= 0) {
+            destroy_device(mouse);
+        }
+        return SKIP_RETURN_CODE;
+    }
+    if (!device_readable(keyboard) || !device_readable(mouse)) {
+        fprintf(stderr, "Created devices can't be read\n");
+        destroy_device(keyboard);
+        destroy_device(mouse);
+        return SKIP_RETURN_CODE;
+    }
+    test_relmouse(keyboard, mouse);
+    test_absolute_mouse(keyboard, mouse);
+    destroy_device(keyboard);
+    destroy_device(mouse);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/**
+ * Fits captures of different aspect ratios into windows, and checks pointer mapping between window and host in both
+ * directions, including positions on the black bars.
+ */
+#include <stdio.h>
+
+#include <SDL.h>
+
+#include "backend/stream/stream_viewport.h"
+#include "test_expect.h"
+
+static void expect_content(const stream_viewport_t *viewport, int x, int y, int w, int h, const char *what) {
+    const SDL_Rect *content = &viewport->content;
+    EXPECT(content->x == x && content->y == y && content->w == w && content->h == h,
+           "%s: expected content %d,%d %dx%d, got %d,%d %dx%d", what, x, y, w, h, content->x, content->y, content->w,
+           content->h);
+}
+
+static void expect_host(const stream_viewport_t *viewport, int x, int y, float host_x, float host_y,
+                        const char *what) {
+    float actual_x = -1, actual_y = -1;
+    EXPECT(stream_viewport_window_to_host(viewport, x, y, &actual_x, &actual_y), "%s: mapping failed", what);
+    EXPECT(SDL_fabsf(actual_x - host_x) < 0.001f && SDL_fabsf(actual_y - host_y) < 0.001f,
+           "%s: expected host %.3f,%.3f, got %.3f,%.3f", what, host_x, host_y, actual_x, actual_y);
+}
+
+static void expect_window(const stream_viewport_t *viewport, float x, float y, int window_x, int window_y,
+                          const char *what) {
+    SDL_Point point = {-1, -1};
+    EXPECT(stream_viewport_host_to_window(viewport, x, y, &point), "%s: mapping failed", what);
+    EXPECT(point.x == window_x && point.y == window_y, "%s: expected window %d,%d, got %d,%d", what, window_x,
+           window_y, point.x, point.y);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+    stream_viewport_t viewport = {0};
+    float host_x, host_y;
+    SDL_Point point;
+    EXPECT(!stream_viewport_window_to_host(&viewport, 10, 10, &host_x, &host_y), "no window: mapping should fail");
+    EXPECT(!stream_viewport_host_to_window(&viewport, 0.5f, 0.5f, &point), "no window: mapping should fail");
+
+    // Unknown capture size takes the whole window
+    stream_viewport_set_window_size(&viewport, 1920, 1080);
+    expect_content(&viewport, 0, 0, 1920, 1080, "unknown capture");
+    expect_host(&viewport, 960, 270, 0.5f, 0.25f, "unknown capture");
+
+    // Same aspect ratio, no bars
+    stream_viewport_set_capture_size(&viewport, 1280, 720);
+    expect_content(&viewport, 0, 0, 1920, 1080, "16:9 in 16:9");
+
+    // 4:3 capture in 16:9 window is pillarboxed
+    stream_viewport_set_capture_size(&viewport, 1024, 768);
+    expect_content(&viewport, 240, 0, 1440, 1080, "pillarbox");
+    expect_host(&viewport, 240 + 720, 540, 0.5f, 0.5f, "pillarbox center");
+    expect_host(&viewport, 100, 540, 0.0f, 0.5f, "pillarbox left bar");
+    expect_host(&viewport, 1900, 1200, 1.0f, 1.0f, "pillarbox right bar");
+    expect_window(&viewport, 0.5f, 0.5f, 960, 540, "pillarbox center");
+    expect_window(&viewport, -1.0f, 2.0f, 240, 1080, "pillarbox clamped");
+
+    // 21:9 capture in 16:9 window is letterboxed
+    stream_viewport_set_capture_size(&viewport, 2560, 1080);
+    expect_content(&viewport, 0, 135, 1920, 810, "letterbox");
+    expect_host(&viewport, 0, 135, 0.0f, 0.0f, "letterbox top left");
+    expect_host(&viewport, 960, 10, 0.5f, 0.0f, "letterbox top bar");
+    expect_host(&viewport, -50, 1079, 0.0f, 1.0f, "letterbox outside window");
+    expect_window(&viewport, 1.0f, 0.5f, 1920, 540, "letterbox right edge");
+
+    // Window resize keeps capture size
+    stream_viewport_set_window_size(&viewport, 3840, 2160);
+    expect_content(&viewport, 0, 270, 3840, 1620, "letterbox after resize");
+
+    // UI rendered at 1080p and scaled up to 4K window, overlay height scales with it
+    SDL_Rect area = {0};
+    EXPECT(stream_viewport_overlay_video_area(&viewport, 1080, 100, &area), "downscaled UI: area failed");
+    EXPECT(area.x == 0 && area.y == 0 && area.w == 3840 && area.h == 2160 - 200,
+           "downscaled UI: expected area 0,0 3840x1960, got %d,%d %dx%d", area.x, area.y, area.w, area.h);
+
+    // UI at window size
+    stream_viewport_set_window_size(&viewport, 1280, 720);
+    EXPECT(stream_viewport_overlay_video_area(&viewport, 720, 100, &area), "native UI: area failed");
+    EXPECT(area.w == 1280 && area.h == 620, "native UI: expected area 1280x620, got %dx%d", area.w, area.h);
+
+    EXPECT(!stream_viewport_overlay_video_area(&viewport, 0, 100, &area), "unknown UI size: area should fail");
+    EXPECT(!stream_viewport_overlay_video_area(&viewport, 720, 0, &area), "unknown overlay: area should fail");
+    return failures == 0 ? 0 : 1;
+}
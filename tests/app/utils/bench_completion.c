@@ -0,0 +1,144 @@
+/**
+ * Compares round trip latency of blocking calls to another thread, with per-call mutex and condition variable
+ * (previous app_run_on_main_sync), against cached per-thread completion.
+ * Usage: bench_completion [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+
+#include "util/completion.h"
+#include "util/mpsc_queue.h"
+
+typedef struct bench_task_t {
+    mpsc_queue_node_t node;
+    void (*fn)(void *data);
+    void *data;
+} bench_task_t;
+
+typedef struct legacy_sync_t {
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    bool done;
+} legacy_sync_t;
+
+typedef struct bench_result_t {
+    double avg_us;
+    double max_us;
+} bench_result_t;
+
+static mpsc_queue_t queue;
+static SDL_sem *queue_filled;
+static SDL_atomic_t running;
+static volatile int counter = 0;
+
+static int consumer(void *arg) {
+    (void) arg;
+    while (SDL_AtomicGet(&running)) {
+        SDL_SemWait(queue_filled);
+        mpsc_queue_node_t *node;
+        while ((node = mpsc_queue_pop(&queue)) != NULL) {
+            bench_task_t *task = mpsc_queue_entry(node, bench_task_t, node);
+            task->fn(task->data);
+        }
+    }
+    return 0;
+}
+
+static void submit(bench_task_t *task) {
+    mpsc_queue_push(&queue, &task->node);
+    SDL_SemPost(queue_filled);
+}
+
+static void legacy_invoke(void *data) {
+    legacy_sync_t *sync = data;
+    SDL_LockMutex(sync->mutex);
+    counter++;
+    sync->done = true;
+    SDL_CondSignal(sync->cond);
+    SDL_UnlockMutex(sync->mutex);
+}
+
+static void legacy_call() {
+    legacy_sync_t sync = {
+            .mutex = SDL_CreateMutex(),
+            .cond = SDL_CreateCond(),
+            .done = false,
+    };
+    bench_task_t task = {.fn = legacy_invoke, .data = &sync};
+    submit(&task);
+    SDL_LockMutex(sync.mutex);
+    while (!sync.done) {
+        SDL_CondWait(sync.cond, sync.mutex);
+    }
+    SDL_UnlockMutex(sync.mutex);
+    SDL_DestroyMutex(sync.mutex);
+    SDL_DestroyCond(sync.cond);
+}
+
+static void completion_invoke(void *data) {
+    counter++;
+    completion_signal(data);
+}
+
+static void completion_call() {
+    completion_t *completion = completion_get_current();
+    bench_task_t task = {.fn = completion_invoke, .data = completion};
+    submit(&task);
+    completion_wait(completion);
+}
+
+static bench_result_t run(void (*call)(), int iterations) {
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 total = 0, max = 0;
+    for (int i = 0; i < iterations; i++) {
+        Uint64 begin = SDL_GetPerformanceCounter();
+        call();
+        Uint64 elapsed = SDL_GetPerformanceCounter() - begin;
+        total += elapsed;
+        if (elapsed > max) {
+            max = elapsed;
+        }
+    }
+    bench_result_t result = {
+            .avg_us = (double) total * 1000000.0 / (double) frequency / iterations,
+            .max_us = (double) max * 1000000.0 / (double) frequency,
+    };
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+    if (iterations <= 0) {
+        return 1;
+    }
+    SDL_Init(0);
+    mpsc_queue_init(&queue);
+    queue_filled = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&running, 1);
+    SDL_Thread *thread = SDL_CreateThread(consumer, "consumer", NULL);
+
+    // Warm up, so both run with the consumer thread scheduled
+    run(legacy_call, iterations / 10 + 1);
+    run(completion_call, iterations / 10 + 1);
+
+    bench_result_t legacy = run(legacy_call, iterations);
+    bench_result_t cached = run(completion_call, iterations);
+
+    SDL_AtomicSet(&running, 0);
+    SDL_SemPost(queue_filled);
+    SDL_WaitThread(thread, NULL);
+    SDL_DestroySemaphore(queue_filled);
+
+    int expected = (iterations / 10 + 1) * 2 + iterations * 2;
+    if (counter != expected) {
+        fprintf(stderr, "%d calls made, but %d completed\n", expected, counter);
+        return 1;
+    }
+    printf("%d round trips\n", iterations);
+    printf("legacy:  avg %8.2f us, max %8.2f us\n", legacy.avg_us, legacy.max_us);
+    printf("cached:  avg %8.2f us, max %8.2f us\n", cached.avg_us, cached.max_us);
+    SDL_Quit();
+    return 0;
+}